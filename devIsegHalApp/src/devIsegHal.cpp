@@ -33,12 +33,15 @@
 // ANSI C/C++ includes
 #include <algorithm>
 #include <cerrno>
+#include <climits>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <iostream>
-#include <list>
+#include <map>
+#include <set>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -55,7 +58,8 @@
 #include <iocLog.h>
 #include <iocsh.h>
 #include <recGbl.h>
-#include <epicsMessageQueue.h>
+#include <epicsGuard.h>
+#include <epicsAtomic.h>
 // local includes
 #include "devIsegHalClasses.hpp"
 
@@ -66,22 +70,27 @@
 //_____ L O C A L S ____________________________________________________________
 #define RECV_Q_SIZE 1000        /* Num messages to buffer */
 
-
-typedef enum {
-  GET_ITEM = 0,
-  SET_ITEM = 1,
-  SET_ITEM_GLOBAL = 2,
-	CLOSE_CONN = 3,
-} devIsegHal_req_t;
-
-typedef struct {
-      devIsegHal_info_t *pdata;
-      devIsegHal_req_t reqType;
-      char value[VALUE_SIZE];
-} devIsegHal_queue_t;
-
 static isegHalThread* myIsegHalThread = NULL;
-static epicsMessageQueueId isegClientQueue = NULL;
+static double isegPollIntervall[ NUM_POLL_CLASSES ] = { 0.5, 5., 60., 0. };
+static unsigned isegDebug = 0;
+static unsigned isegEventMode = 0;
+static double isegEventIntervall = 0.1;
+static std::vector< isegHalWorker* > isegWorkers;
+static unsigned isegNumWorkers = 1;
+static unsigned isegLaneDepth[ NUM_LANES ] = { RECV_Q_SIZE, RECV_Q_SIZE, RECV_Q_SIZE };
+static std::vector< unsigned > isegWriters;  // records writing via each worker
+static std::vector< isegHalDispatcher* > isegDispatchers;
+static unsigned isegNumDispatchers = 1;
+static unsigned isegDispatchPriority = epicsThreadPriorityScanLow - 1; // as EPICS callbacks priorityLow
+static size_t isegDispatchOverflows = 0;
+
+static void isegShutdown( void* );
+
+enum {
+  ISEG_READ_FAILED = 0,
+  ISEG_READ_QUEUED,
+  ISEG_READ_JOINED
+};
 
 //_____ F U N C T I O N S ______________________________________________________
 double timespec_diff( const struct timespec * stop, const struct timespec * start )
@@ -126,10 +135,7 @@ static std::ostream& operator<<( std::ostream& ost, const IsegResult& result ) {
 //! Disconnects all registered interfaces
 //------------------------------------------------------------------------------
 isegHalConnectionHandler::~isegHalConnectionHandler() {
-  devIsegHal_queue_t qmsg = { NULL, CLOSE_CONN, NULL};
-  if (epicsMessageQueueTrySend(isegClientQueue, &qmsg, sizeof(devIsegHal_queue_t))){
-       fprintf( stderr, "\033[31;1m: isegHal Mgt Queue Overflowed \033[0m\n" );
-  }
+  isegShutdown( NULL );
   _interfaces.clear();
   std::cout << "(" << __FUNCTION__ << ") Cleaning up: " << epicsThreadGetNameSelf() << std::endl;
 }
@@ -162,6 +168,7 @@ void isegHalConnectionHandler::setName(std::string name) {
 }
 
 void isegHalConnectionHandler::storeHalNames(std::vector<std::string> &dstinterfaces) {
+  epicsGuard< epicsMutex > guard( _lock );
         std::vector< std::string >::iterator it = _interfaces.begin();
         for( ; it != _interfaces.end(); ++it ) {
     dstinterfaces.push_back( (*it) );
@@ -176,9 +183,12 @@ void isegHalConnectionHandler::storeHalNames(std::vector<std::string> &dstinterf
 bool isegHalConnectionHandler::connect( std::string const& name, std::string const& interface ) {
   std::cout << "(" << __FUNCTION__ << ") function in  thread id: " << epicsThreadGetNameSelf() << std::endl;
 
-  std::vector< std::string >::iterator it;
-  it = std::find( _interfaces.begin(), _interfaces.end(), name );
-  if( it != _interfaces.end() ) return true;
+  {
+    epicsGuard< epicsMutex > guard( _lock );
+    std::vector< std::string >::iterator it;
+    it = std::find( _interfaces.begin(), _interfaces.end(), name );
+    if( it != _interfaces.end() ) return true;
+  }
   //  std::cout << "Trying to connect to '" << interface << "'" << std::endl;
   IsegResult status = iseg_connect( name.c_str(), interface.c_str(), NULL );
   if ( ISEG_OK != status ) {
@@ -189,15 +199,99 @@ bool isegHalConnectionHandler::connect( std::string const& name, std::string con
     return false;
   }
   // iseg HAL starts collecting data from hardware after connect.
-  // wait 5 secs to let all values 'initialize'
-  sleep( 5 );
+  // wait until it provides data to let all values 'initialize'
+  if( !waitReady( name ) ) {
+    fprintf( stderr, "\033[31;1misegHAL interface '%s' provides no data after %.1f s\033[0m\n",
+             interface.c_str(), ISEG_READY_TIMEOUT );
+  }
 
+  epicsGuard< epicsMutex > guard( _lock );
   _interfaces.push_back( name );
-  _halInterface = interface;
-  _name = name;
   return true;
 }
 
+//------------------------------------------------------------------------------
+//! @brief       Register an interface connected via isegHalConnect
+//! @param [in]  name        deviseg internal name of the interface handle
+//! @param [in]  interface   name of the hardware interface
+//!
+//! Each registered interface gets its own worker sessions. Sessions of
+//! devIsegHal (workers, prefetch) are connected, but not registered.
+//! The first registered interface is kept as default interface.
+//------------------------------------------------------------------------------
+void isegHalConnectionHandler::registerInterface( std::string const& name, std::string const& interface ) {
+  epicsGuard< epicsMutex > guard( _lock );
+  if( std::find( _names.begin(), _names.end(), name ) != _names.end() ) return;
+  _names.push_back( name );
+  _halInterfaces.push_back( interface );
+  if( _name.empty() ) {
+    _halInterface = interface;
+    _name = name;
+  }
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get number of registered interfaces
+//------------------------------------------------------------------------------
+size_t isegHalConnectionHandler::numInterfaces() {
+  epicsGuard< epicsMutex > guard( _lock );
+  return _names.size();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get position of an interface in the order of registration
+//! @param [in]  name    deviseg internal name of the interface handle
+//! @return      Index of the interface, -1 if not registered
+//------------------------------------------------------------------------------
+int isegHalConnectionHandler::indexOf( std::string const& name ) {
+  epicsGuard< epicsMutex > guard( _lock );
+  std::vector< std::string >::iterator it = std::find( _names.begin(), _names.end(), name );
+  return ( it == _names.end() ) ? -1 : (int)( it - _names.begin() );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get name of a registered interface
+//! @param [in]  index   Index of the interface
+//------------------------------------------------------------------------------
+std::string isegHalConnectionHandler::getName( size_t index ) {
+  epicsGuard< epicsMutex > guard( _lock );
+  return ( index < _names.size() ) ? _names[ index ] : std::string();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get hardware interface of a registered interface
+//! @param [in]  index   Index of the interface
+//------------------------------------------------------------------------------
+std::string isegHalConnectionHandler::getHalInterface( size_t index ) {
+  epicsGuard< epicsMutex > guard( _lock );
+  return ( index < _halInterfaces.size() ) ? _halInterfaces[ index ] : std::string();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Wait until isegHAL provides data for a new session
+//! @param [in]  name    deviseg internal name of the interface handle
+//! @return      false if no data within ISEG_READY_TIMEOUT
+//!
+//! isegHAL reads all items from the hardware in cycles. Data is complete
+//! once the CycleCounter has advanced. The time spent reading the counter
+//! counts towards the timeout.
+//------------------------------------------------------------------------------
+bool isegHalConnectionHandler::waitReady( std::string const& name ) {
+  std::string first;
+  epicsTimeStamp start, now;
+  epicsTimeGetCurrent( &start );
+  do {
+    IsegItem item = iseg_getItem( name.c_str(), "CycleCounter" );
+    if( strcmp( item.quality, ISEG_ITEM_QUALITY_OK ) == 0 ) {
+      if( first.empty() ) first = item.value;
+      else if( first.compare( item.value ) != 0 ) return true;
+    }
+    epicsThreadSleep( ISEG_READY_POLL );
+    epicsTimeGetCurrent( &now );
+  } while( epicsTimeDiffInSeconds( &now, &start ) < ISEG_READY_TIMEOUT );
+  return false;
+}
+
 //------------------------------------------------------------------------------
 //! @brief       Check if an interface is connected
 //! @param [in]  name    deviseg internal name of the interface handle
@@ -205,6 +299,7 @@ bool isegHalConnectionHandler::connect( std::string const& name, std::string con
 bool isegHalConnectionHandler::connected( std::string const& name ) {
   if( name.compare( "AUTO" ) == 0 ) return true;
 
+  epicsGuard< epicsMutex > guard( _lock );
   std::vector< std::string >::iterator it;
   it = std::find( _interfaces.begin(), _interfaces.end(), name );
   if( it != _interfaces.end() ) return true;
@@ -216,6 +311,7 @@ bool isegHalConnectionHandler::connected( std::string const& name ) {
 //! @param [in]  name    deviseg internal name of the interface handle
 //------------------------------------------------------------------------------
 void isegHalConnectionHandler::disconnect( std::string const& name ) {
+  epicsGuard< epicsMutex > guard( _lock );
   std::vector< std::string >::iterator it;
   it = std::find( _interfaces.begin(), _interfaces.end(), name );
 
@@ -240,155 +336,1172 @@ void regCallback( dbCommon* prec, devIsegHal_info_t *pinfo ) {
     callbackSetPriority( priorityLow, pcallback );
     pinfo->pcallback = pcallback;
   }
+  pinfo->precord = prec;
 }
 
-static void isegMgtTask() {
-  std::cout << "(" << __FUNCTION__ << ") function in  thread id: " << epicsThreadGetNameSelf() << std::endl;
-  std::string name = /*"_" +*/ isegHalConnectionHandler::instance().getName() + "_MOD";
-  std::string interface =  isegHalConnectionHandler::instance().getHalInterface();
-  isegHalConnectionHandler::instance().setName(name);
+//------------------------------------------------------------------------------
+//! @brief       Get current time of the monotonic clock
+//! @return      Time in seconds
+//------------------------------------------------------------------------------
+static double isegMonotonicNow() {
+  struct timespec now;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  return now.tv_sec + now.tv_nsec * 1.e-9;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get an info tag of a record
+//! @param [in]  prec  Address of the record
+//! @param [in]  name  Name of the info tag
+//! @return      Value of the info tag, empty string if not set
+//------------------------------------------------------------------------------
+static std::string isegGetInfo( dbCommon *prec, const char* name ) {
+  std::string value;
+  DBENTRY entry;
+  dbInitEntry( pdbbase, &entry );
+  if( 0 == dbFindRecord( &entry, prec->name ) ) {
+    const char* info = dbGetInfo( &entry, name );
+    if( info ) value = info;
+  }
+  dbFinishEntry( &entry );
+  return value;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Check if a boolean info tag of a record is set
+//! @param [in]  prec  Address of the record
+//! @param [in]  name  Name of the info tag
+//! @return      true if the info tag is "YES", "TRUE" or "1"
+//------------------------------------------------------------------------------
+static bool isegInfoFlag( dbCommon *prec, const char* name ) {
+  std::string value = isegGetInfo( prec, name );
+  std::transform( value.begin(), value.end(), value.begin(), ::toupper );
+  return ( "YES" == value || "TRUE" == value || "1" == value );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get the poll rate class of a record
+//! @param [in]  prec  Address of the record
+//! @return      Poll class set with info tag "isegPoll", default POLL_NORMAL
+//------------------------------------------------------------------------------
+static devIsegHal_poll_t isegPollClassOf( dbCommon *prec ) {
+  std::string value = isegGetInfo( prec, "isegPoll" );
+  std::transform( value.begin(), value.end(), value.begin(), ::tolower );
+  if( value.empty() || "normal" == value ) return POLL_NORMAL;
+  if( "fast" == value ) return POLL_FAST;
+  if( "slow" == value ) return POLL_SLOW;
+  if( "once" == value ) return POLL_ONCE;
+  fprintf( stderr, "\033[31;1m%s: Invalid poll class '%s', using 'normal'\033[0m\n", prec->name, value.c_str() );
+  return POLL_NORMAL;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Set the deadband of a record
+//! @param [in]  prec   Address of the record
+//! @param [in]  pinfo  Address of the record's private data structure
+//!
+//! The info tag "isegDeadband" is either an absolute change ("0.01") or
+//! a change relative to the last value ("0.5%").
+//------------------------------------------------------------------------------
+static void isegDeadbandOf( dbCommon *prec, devIsegHal_info_t *pinfo ) {
+  pinfo->deadband = 0.;
+  pinfo->relative = false;
+  std::string value = isegGetInfo( prec, "isegDeadband" );
+  if( value.empty() ) return;
+
+  char *end = NULL;
+  epicsFloat64 deadband = strtod( value.c_str(), &end );
+  bool relative = ( '%' == *end );
+  if( relative ) ++end;
+  if( end == value.c_str() || *end != '\0' || deadband < 0. || ISEG_VALUE_STRING == pinfo->vtype || pinfo->bit >= 0 ) {
+    fprintf( stderr, "\033[31;1m%s: Invalid deadband '%s', ignored\033[0m\n", prec->name, value.c_str() );
+    return;
+  }
+  pinfo->deadband = relative ? deadband / 100. : deadband;
+  pinfo->relative = relative;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get the worker shard of an isegHAL object
+//! @param [in]  object  Fully qualified object name ([line.[module.[channel.]]]item)
+//! @return      Index of the worker serving this object among the workers
+//!              of its interface
+//!
+//! Items are sharded by CAN line and module, so that all requests for
+//! one module are handled in order by the same worker thread.
+//------------------------------------------------------------------------------
+static unsigned isegShardOf( const char* object ) {
+  if( isegNumWorkers <= 1 ) return 0;
+
+  char *end = NULL;
+  unsigned long line = strtoul( object, &end, 10 );
+  if( end == object || '.' != *end ) return 0; // system item
+
+  const char *pmod = end + 1;
+  unsigned long module = strtoul( pmod, &end, 10 );
+  if( end == pmod || '.' != *end ) return line % isegNumWorkers; // line item
+
+  return ( line * 1009 + module ) % isegNumWorkers;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get the worker serving an isegHAL object of an interface
+//! @param [in]  interface  deviseg internal name of the interface handle
+//! @param [in]  object     Fully qualified object name ([line.[module.[channel.]]]item)
+//! @return      Index of the worker in isegWorkers
+//!
+//! Each interface has its own isegNumWorkers workers, in the order the
+//! interfaces have been connected. Unknown interfaces ("AUTO") are served
+//! by the workers of the first interface.
+//------------------------------------------------------------------------------
+static unsigned isegWorkerOf( const char* interface, const char* object ) {
+  int index = isegHalConnectionHandler::instance().indexOf( interface );
+  if( index < 0 ) index = 0;
+  return index * isegNumWorkers + isegShardOf( object );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Count a record writing via its worker
+//! @param [in]  pinfo  Address of the record's private data structure
+//!
+//! Must only be called during record initialization, after the worker
+//! of the record has been set.
+//------------------------------------------------------------------------------
+static void isegCountWriter( devIsegHal_info_t const* pinfo ) {
+  if( isegWriters.size() <= pinfo->shard ) isegWriters.resize( pinfo->shard + 1, 0 );
+  ++isegWriters[ pinfo->shard ];
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get the I/O Intr scan list of the channel or module of an item
+//! @param [in]  interface  Name of the interface
+//! @param [in]  object     Fully qualified object name ([line.[module.[channel.]]]item)
+//! @param [in]  shard      Worker serving the item
+//! @return      Address of the scan list, created for the first record of the list
+//!
+//! Channel items have one list per channel, so an update of one channel
+//! does not process the records of the other channels. Module items and
+//! array records (channel "*") share the list of the module, system and
+//! line items have one list per interface or line.
+//! The key of a list never spans several worker shards, as the shard is
+//! chosen by line and module. The queued flag of a list is therefore only
+//! touched by one worker. Must only be called during record initialization.
+//------------------------------------------------------------------------------
+static isegScanGroup* isegScanGroupOf( const char* interface, const char* object, unsigned shard ) {
+  static std::map< std::string, isegScanGroup* > groups;
+
+  size_t len = 0;
+  char *end = NULL;
+  strtoul( object, &end, 10 );
+  if( end != object && '.' == *end ) {
+    len = end - object; // line item
+    const char *pmod = end + 1;
+    strtoul( pmod, &end, 10 );
+    if( end != pmod && '.' == *end ) {
+      len = end - object; // module item
+      const char *pchan = end + 1;
+      strtoul( pchan, &end, 10 );
+      if( end != pchan && '.' == *end ) len = end - object; // channel item
+    }
+  }
+  std::string key = std::string( interface ) + ":" + std::string( object, len );
+
+  std::map< std::string, isegScanGroup* >::iterator it = groups.find( key );
+  if( it != groups.end() ) {
+    if( it->second->shard != shard )
+      fprintf( stderr, "\033[31;1mScan list '%s' served by workers %u and %u\033[0m\n",
+               key.c_str(), it->second->shard, shard );
+    return it->second;
+  }
+  isegScanGroup* pscan = new isegScanGroup;
+  scanIoInit( &pscan->ioscanpvt );
+  pscan->queued = false;
+  pscan->shard = shard;
+  groups[ key ] = pscan;
+  return pscan;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Clear in-flight flags of an item
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @param [in]  flags  Flags to be cleared
+//------------------------------------------------------------------------------
+static void isegClearInflight( devIsegHal_info_t *pinfo, int flags ) {
+  int pending;
+  do {
+    pending = epicsAtomicGetIntT( &pinfo->inflight );
+  } while( epicsAtomicCmpAndSwapIntT( &pinfo->inflight, pending, pending & ~flags ) != pending );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Take the update delivered to a record scanned on I/O Intr
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @return      false if no update is ready for the record
+//------------------------------------------------------------------------------
+static bool isegTakeUpdate( devIsegHal_info_t *pinfo ) {
+  int pending;
+  do {
+    pending = epicsAtomicGetIntT( &pinfo->inflight );
+    if( !( pending & ISEG_INFLIGHT_UPDATE ) ) return false;
+  } while( epicsAtomicCmpAndSwapIntT( &pinfo->inflight, pending, pending & ~ISEG_INFLIGHT_UPDATE ) != pending );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Send a request to the worker serving an item
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @param [in]  req    Type of request
+//! @param [in]  lane   Priority lane of the request
+//! @param [in]  seq    Sequence number of write requests
+//! @return      false if the request could not be queued
+//------------------------------------------------------------------------------
+static bool isegQueueRequest( devIsegHal_info_t *pinfo, devIsegHal_req_t req, devIsegHal_lane_t lane, epicsUInt32 seq = 0 ) {
+  if( isegWorkers.empty() ) return false;
+  return isegWorkers[ pinfo->shard % isegWorkers.size() ]->request( pinfo, req, lane, seq );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Request a read of an item
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @param [in]  flag   ISEG_INFLIGHT_POLL or ISEG_INFLIGHT_READ
+//! @param [in]  urgent Queue a poll in the read lane (e.g. after an event)
+//! @return      ISEG_READ_QUEUED, ISEG_READ_JOINED or ISEG_READ_FAILED
+//!
+//! If a read of this item is already waiting in the queue, the new
+//! request joins it instead of adding another call to isegHAL.
+//! Polls are also skipped while the record is processed with the result
+//! of a previous read. A read requested by record processing is queued
+//! in the read lane even if a poll is pending, whichever request is
+//! handled first serves both.
+//------------------------------------------------------------------------------
+static int isegRequestRead( devIsegHal_info_t *pinfo, int flag, bool urgent = false ) {
+  int pending;
+  do {
+    pending = epicsAtomicGetIntT( &pinfo->inflight );
+    if( ISEG_INFLIGHT_POLL == flag && pending ) return ISEG_READ_JOINED;
+  } while( epicsAtomicCmpAndSwapIntT( &pinfo->inflight, pending, pending | flag ) != pending );
+
+  if( pending & flag ) return ISEG_READ_JOINED;
+  devIsegHal_lane_t lane = ( ISEG_INFLIGHT_POLL == flag && !urgent ) ? LANE_POLL : LANE_READ;
+  if( isegQueueRequest( pinfo, GET_ITEM, lane ) ) return ISEG_READ_QUEUED;
+
+  isegClearInflight( pinfo, flag );
+  return ISEG_READ_FAILED;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Check if the worker serving an item is busy with polls
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @return      true if the poll lane of the worker is at least half full
+//------------------------------------------------------------------------------
+static bool isegPollCongested( devIsegHal_info_t *pinfo ) {
+  if( isegWorkers.empty() ) return false;
+  isegHalWorker* worker = isegWorkers[ pinfo->shard % isegWorkers.size() ];
+  return ( 2 * worker->pending( LANE_POLL ) >= worker->capacity( LANE_POLL ) );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Request a write of an item
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @param [in]  req    SET_ITEM or SET_ITEM_GLOBAL
+//! @param [in]  value  Value cstring to be written
+//! @return      false if the request could not be queued
+//!
+//! The value is stored in the write slot of the record, the message to
+//! the worker only carries the handle. Records stay active (PACT) until
+//! the write has been completed, so normally only one write per record
+//! is pending. If a write is still pending anyway, only the value in the
+//! slot is replaced and the pending request writes the newer value.
+//! Array records take the staged values of all channels into the slot.
+//------------------------------------------------------------------------------
+static bool isegRequestWrite( devIsegHal_info_t *pinfo, devIsegHal_req_t req, const char* value ) {
+  epicsMutexMustLock( pinfo->wlock );
+  strncpy( pinfo->wvalue, value, VALUE_SIZE );
+  pinfo->wvalue[VALUE_SIZE - 1] = 0;
+  if( pinfo->parray ) pinfo->parray->wvalues = pinfo->parray->staged;
+  epicsUInt32 seq = ++pinfo->wseq;
+
+  int pending;
+  do {
+    pending = epicsAtomicGetIntT( &pinfo->inflight );
+  } while( epicsAtomicCmpAndSwapIntT( &pinfo->inflight, pending, pending | ISEG_INFLIGHT_WRITE ) != pending );
+
+  bool queued = true;
+  if( !( pending & ISEG_INFLIGHT_WRITE ) ) {
+    queued = isegQueueRequest( pinfo, req, LANE_WRITE, seq );
+    if( !queued ) isegClearInflight( pinfo, ISEG_INFLIGHT_WRITE );
+  }
+  epicsMutexUnlock( pinfo->wlock );
+  return queued;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Take the value to be written from the write slot
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @param [out] value  Value cstring to be written
+//! @param [out] values Values of the channels to be written (array records)
+//! @return      Sequence number of the value
+//------------------------------------------------------------------------------
+static epicsUInt32 isegTakeWrite( devIsegHal_info_t *pinfo, char* value, std::vector< epicsFloat64 >* values = NULL ) {
+  epicsMutexMustLock( pinfo->wlock );
+  memcpy( value, pinfo->wvalue, VALUE_SIZE );
+  if( values && pinfo->parray ) *values = pinfo->parray->wvalues;
+  epicsUInt32 seq = pinfo->wseq;
+  epicsMutexUnlock( pinfo->wlock );
+  return seq;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Process a record with the result of its request
+//! @param [in]  pinfo  Address of the record's private data structure
+//!
+//! The record is processed by the dispatcher thread it belongs to. The
+//! EPICS callback is used only if no dispatcher threads are running or
+//! the queue of the dispatcher is full.
+//------------------------------------------------------------------------------
+static void isegComplete( devIsegHal_info_t* pinfo ) {
+  if( !isegDispatchers.empty() ) {
+    size_t index = ( (size_t)pinfo / sizeof( devIsegHal_info_t ) ) % isegDispatchers.size();
+    if( isegDispatchers[ index ]->request( pinfo ) ) return;
+    epicsAtomicIncrSizeT( &isegDispatchOverflows );
+  }
+  callbackRequest( pinfo->pcallback );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Complete a write request
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @param [in]  seq    Sequence number of the value which has been written
+//! @return      false if the slot has been updated meanwhile, the newer
+//!              value has to be written as well
+//------------------------------------------------------------------------------
+static bool isegCompleteWrite( devIsegHal_info_t* _pdata, epicsUInt32 seq ) {
+  epicsMutexMustLock( _pdata->wlock );
+  if( seq != _pdata->wseq ) {
+    epicsMutexUnlock( _pdata->wlock );
+    return false;
+  }
+  _pdata->pflag = P_ASYNC; // Normal processing write always async
+  epicsTimeGetCurrent( &_pdata->time ); // get time after successful write to device
+
+  int pending;
+  do {
+    pending = epicsAtomicGetIntT( &_pdata->inflight );
+  } while( epicsAtomicCmpAndSwapIntT( &_pdata->inflight, pending,
+             ( pending & ~ISEG_INFLIGHT_WRITE ) | ISEG_INFLIGHT_CALLBACK ) != pending );
+  epicsMutexUnlock( _pdata->wlock );
+  isegComplete( _pdata );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       C'tor of isegHalWorker
+//! @param [in]  index      Index of the worker (= shard number)
+//! @param [in]  session    Name of the isegHAL session used by this worker
+//! @param [in]  interface  Name of the hardware interface
+//! @param [in]  depths     Max. number of messages in each lane
+//------------------------------------------------------------------------------
+isegHalWorker::isegHalWorker( unsigned index, std::string const& session, std::string const& interface,
+                              const unsigned* depths )
+  : thread( *this, "isegACtrlTask", epicsThreadGetStackSize( epicsThreadStackMedium ), epicsThreadPriorityHigh ),
+    _index( index ),
+    _session( session ),
+    _interface( interface ),
+    _wakeup( NULL ),
+    _ready( NULL ),
+    _done( NULL ),
+    _sleeping( 0 ),
+    _handled( 0 )
+{
+  for( unsigned i = 0; i < NUM_LANES; ++i )
+    _lanes[i] = new isegHalRing( depths[i] );
+  _wakeup = epicsEventCreate( epicsEventEmpty );
+  _ready = epicsEventMustCreate( epicsEventEmpty );
+  _done = epicsEventMustCreate( epicsEventEmpty );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       D'tor of isegHalWorker
+//------------------------------------------------------------------------------
+isegHalWorker::~isegHalWorker() {
+  for( unsigned i = 0; i < NUM_LANES; ++i ) delete _lanes[i];
+  if( _wakeup ) epicsEventDestroy( _wakeup );
+  epicsEventDestroy( _ready );
+  epicsEventDestroy( _done );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Queue a request for this worker
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @param [in]  req    Type of request
+//! @param [in]  lane   Priority lane of the request
+//! @param [in]  seq    Sequence number of write requests
+//! @return      false if the lane is full
+//!
+//! Requests are dropped if their lane is full, the caller never waits.
+//! The write lane holds a write of each record served by the worker, so
+//! writes are not dropped (see isegInitWorkers).
+//! The worker is only woken up if it is waiting for new requests.
+//------------------------------------------------------------------------------
+bool isegHalWorker::request( devIsegHal_info_t* pinfo, devIsegHal_req_t req, devIsegHal_lane_t lane, epicsUInt32 seq ) {
+  devIsegHal_msg_t qmsg;
+  qmsg.pdata = pinfo;
+  qmsg.reqType = req;
+  qmsg.seq = seq;
+  return post( qmsg, lane );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Queue a check of the EventStatus words of a module
+//! @param [in]  pgroup  Address of the watched module
+//! @return      false if the lane is full
+//------------------------------------------------------------------------------
+bool isegHalWorker::request( isegEventGroup* pgroup ) {
+  devIsegHal_msg_t qmsg;
+  qmsg.pgroup = pgroup;
+  qmsg.reqType = CHECK_EVENTS;
+  qmsg.seq = 0;
+  return post( qmsg, LANE_READ );
+}
 
-  if( !isegHalConnectionHandler::instance().connect(name, interface ) ){
-    fprintf( stderr, "\033[31;1mCannot connect to isegHAL interface %s(%s)\033[0m\n", name.c_str(), interface.c_str());
+//------------------------------------------------------------------------------
+//! @brief       Add a message to a lane and wake up the worker
+//! @param [in]  qmsg  Message
+//! @param [in]  lane  Priority lane of the request
+//! @return      false if the lane is full
+//------------------------------------------------------------------------------
+bool isegHalWorker::post( devIsegHal_msg_t const& qmsg, devIsegHal_lane_t lane ) {
+  if( !_wakeup ) return false;
+  if( !_lanes[lane]->push( qmsg ) ) return false;
+
+  // full barrier: publish the message before looking at the worker's state
+  if( epicsAtomicAddIntT( &_sleeping, 0 ) ) epicsEventSignal( _wakeup );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Take the next request from the lanes
+//! @param [out] msg  Request
+//! @return      false if all lanes are empty
+//------------------------------------------------------------------------------
+bool isegHalWorker::receive( devIsegHal_msg_t& msg ) {
+  for( unsigned i = 0; i < NUM_LANES; ++i ) {
+    if( _lanes[i]->pop( msg ) ) return true;
   }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Run operation of worker thread
+//!
+//! Connects the own session to the isegHAL server and handles the
+//! requests from the queue until the connection is closed.
+//------------------------------------------------------------------------------
+void isegHalWorker::run() {
+  std::cout << "(" << __FUNCTION__ << ") worker " << _index << " in thread id: " << epicsThreadGetNameSelf() << std::endl;
 
-  std::vector<std::string> _sinterfaces;
-  //keep a copy of created interfaces for cleanup
-  isegHalConnectionHandler::instance().storeHalNames( _sinterfaces );
+  if( !isegHalConnectionHandler::instance().connect( _session, _interface ) ){
+    fprintf( stderr, "\033[31;1mCannot connect to isegHAL interface %s(%s)\033[0m\n", _session.c_str(), _interface.c_str() );
+  }
+  epicsEventSignal( _ready );
 
-  devIsegHal_queue_t rmsg;
-  while(1) {
+  devIsegHal_msg_t rmsg;
+  while( true ) {
     /* Wait for event from client task */
-    int msg = epicsMessageQueuePending (isegClientQueue );
-    int rcv = epicsMessageQueueReceive(isegClientQueue, &rmsg, sizeof(rmsg));
-    if( rcv  < 1 ) continue;
-    std::string _name = isegHalConnectionHandler::instance().getName();
-    devIsegHal_req_t  _req = rmsg.reqType;
-
-    devIsegHal_info_t* _pdata = (devIsegHal_info_t*)rmsg.pdata;
-    if(!_pdata || _req == CLOSE_CONN) {
-      std::cout << "Closing socket " << " (" << __FUNCTION__ << ")" << " thread id: "
-                << epicsThreadGetNameSelf() << std::endl;
-      epicsThreadSleep(1);
-      std::vector< std::string >::iterator it = _sinterfaces.begin();
-      for( ; it != _sinterfaces.end(); ++it ) {
-        IsegResult status = iseg_disconnect( it->c_str() );
-        if ( ISEG_OK != status ) {
-            std::cerr << "\033[31;1m Cannot disconnect from isegHAL interface '"
-                      << (*it) << "'.\033[0m" << std::endl;
-        }
+    if( !_scans.empty() && ( ISEG_SCAN_BATCH <= ++_handled || idle() ) )
+      requestScans();
+    if( !receive( rmsg ) ) {
+      // announce the wait, then look again to not miss a request
+      // queued in between
+      epicsAtomicCmpAndSwapIntT( &_sleeping, 0, 1 );
+      if( !receive( rmsg ) ) {
+        epicsEventWait( _wakeup );
+        epicsAtomicSetIntT( &_sleeping, 0 );
+        continue;
       }
+      epicsAtomicSetIntT( &_sleeping, 0 );
+    }
+
+    if( CHECK_EVENTS == rmsg.reqType ) {
+      checkEvents( rmsg.pgroup );
+      continue;
     }
 
-    devIsegHal_pflags_t _proc = _pdata->pflag;
-    std::string  _value = rmsg.value;
-    IsegItem item = EmptyIsegItem;
+    devIsegHal_info_t* _pdata = rmsg.pdata;
+    if( !_pdata || rmsg.reqType == CLOSE_CONN ) {
+      std::cout << "Closing socket " << _session << " (" << __FUNCTION__ << ")" << " thread id: "
+                << epicsThreadGetNameSelf() << std::endl;
+      IsegResult status = iseg_disconnect( _session.c_str() );
+      if ( ISEG_OK != status ) {
+        std::cerr << "\033[31;1m Cannot disconnect from isegHAL interface '"
+                  << _session << "'.\033[0m" << std::endl;
+      }
+      epicsEventSignal( _done );
+      return;
+    }
 
-    switch(_req) {
+    switch( rmsg.reqType ) {
       case GET_ITEM:
-        switch(_proc) {
-          case P_ASYNC:
-            item = iseg_getItem(_name.c_str(), (_pdata)->object);
-            memcpy( _pdata->quality, item.quality,  QUALITY_SIZE );
-            memcpy( _pdata->value, item.value, VALUE_SIZE );
-            memcpy( _pdata->rtime, item.timeStampLastChanged, TIME_SIZE );
-#ifdef CHECK_LAST_REFRESHED
-            memcpy( _pdata->rtime, item.timeStampLastChanged, TIME_SIZE );
-#endif
-            _pdata->pflag = _proc;  // better be sure;
-            callbackRequest( (_pdata)->pcallback );
-          break;
-          case P_IO_INTR:
-          {
-            bool quality = true;
-            bool timestampchanged = true;
-            item = iseg_getItem(_name.c_str(), (_pdata)->object);
-            if( strcmp( item.quality, ISEG_ITEM_QUALITY_OK ) != 0 ) quality = false;
-
-            epicsUInt32 seconds = 0;
-            epicsUInt32 microsecs = 0;
-            if( sscanf( item.timeStampLastChanged, "%u.%u", &seconds, &microsecs ) != 2 ) timestampchanged = false;
-
-            epicsTimeStamp time;
-            time.secPastEpoch = seconds - POSIX_TIME_AT_EPICS_EPOCH;
-            time.nsec = microsecs * 100000;
-
-            if( quality && timestampchanged ) {
-              if( _pdata->time.secPastEpoch != time.secPastEpoch || _pdata->time.nsec != time.nsec ) {
-                // value was updated in isegHAL
-                memcpy( _pdata->value, item.value, VALUE_SIZE );
-                _pdata->time = time;
-                _pdata->pflag = _proc;  // better be sure;
-                callbackRequest( _pdata->pcallback );
-              }
-            }
-          break;
-          }
-          default:
-          break;
-        }
-      break;
+        getItem( _pdata );
+        break;
       case SET_ITEM:
-      {
-        //std::cout << "SET_ITEM: "<< _pdata->object<< " (" << __FUNCTION__ << ") thread id: " << epicsThreadGetNameSelf() << std::endl;
-        //myIsegHalThread->disable();
-        _pdata->ioStatus = ISEG_OK;
-        std::cout << " write request "<< _value.c_str() << " run from thread: " << epicsThreadGetNameSelf() << std::endl;
-        if( iseg_setItem( _pdata->interface, _pdata->object, _value.c_str() ) != ISEG_OK ) {
-          fprintf( stderr, "\033[31;1m%s Error while writing value '%s': '%s'\033[0m\n", _pdata->interface,_pdata->object, _value.c_str() );
-          _pdata->ioStatus = ISEG_ERROR;
-        }
-        _pdata->pflag = P_ASYNC; // Normal processing write always async
-        epicsTimeGetCurrent( &_pdata->time ); // get time after successful write to device
-        callbackRequest( _pdata->pcallback );
-      break;
-      }
+        setItem( _pdata );
+        break;
       case SET_ITEM_GLOBAL:
-      {
-        _pdata->ioStatus = ISEG_OK;
-        if ( iseg_setItem( _pdata->interface, "Configuration", "1" ) != ISEG_OK ) {
-          fprintf( stderr, "\033[31;1m%s Error while writing configuration '%s'\033[0m\n", _pdata->interface,_pdata->object );
-          iseg_setItem( _pdata->interface, "Configuration", "0"); // Restore function
-          _pdata->ioStatus = ISEG_ERROR;
-          continue;
-        }
+        setItemGlobal( _pdata );
+        break;
+      default:
+        break;
+    }
+  }
+}
 
-        if ( iseg_setItem( _pdata->interface, _pdata->object, _value.c_str() ) != ISEG_OK ) {
-          fprintf( stderr, "\033[31;1m%s Error while writing value '%s': '%s'\033[0m\n", _pdata->interface,_pdata->object, _value.c_str() );
-          iseg_setItem( _pdata->interface, "Configuration", "0"); // Restore function
-          _pdata->ioStatus = ISEG_ERROR;
-          continue;
-        }
+//------------------------------------------------------------------------------
+//! @brief       Copy a value cstring of an item to a record
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @param [out] dest   Destination buffer of VALUE_SIZE
+//! @param [in]  value  Value cstring of the item
+//!
+//! For records reading a single bit of an item, the value of this bit
+//! ("0" or "1") is stored instead of the whole item.
+//------------------------------------------------------------------------------
+static void isegCopyValue( devIsegHal_info_t const* pinfo, char* dest, const char* value ) {
+  if( pinfo->bit < 0 ) {
+    memcpy( dest, value, VALUE_SIZE );
+    return;
+  }
+  unsigned long word = strtoul( value, NULL, 0 );
+  dest[0] = ( ( word >> pinfo->bit ) & 0x1 ) ? '1' : '0';
+  dest[1] = 0;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Parse a floating point number
+//! @param [in]  str   Value cstring from isegHAL
+//! @param [out] pval  Parsed value
+//! @return      0 on success, -1 if the cstring doesn't start with a number
+//!
+//! Locale-free replacement of sscanf( "%lf" ). Numbers with up to 15
+//! significant digits and a decimal exponent within +-22 are exact
+//! (mantissa and power of ten are exact doubles), all others are passed
+//! on to strtod.
+//------------------------------------------------------------------------------
+int devIsegHalParseDouble( const char *str, epicsFloat64 *pval ) {
+  static const double pow10[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+  const char *p = str;
+  while( ' ' == *p || '\t' == *p ) ++p;
+  bool neg = ( '-' == *p );
+  if( '-' == *p || '+' == *p ) ++p;
+
+  epicsUInt64 mant = 0;
+  int digits = 0;   // significant digits in mant
+  int exp10 = 0;
+  bool any = false;
+  for( ; *p >= '0' && *p <= '9'; ++p ) {
+    any = true;
+    if( digits < 19 ) {
+      mant = mant * 10 + ( *p - '0' );
+      if( mant ) ++digits;
+    } else {
+      ++exp10;
+    }
+  }
+  if( '.' == *p ) {
+    for( ++p; *p >= '0' && *p <= '9'; ++p ) {
+      any = true;
+      if( digits < 19 ) {
+        mant = mant * 10 + ( *p - '0' );
+        if( mant ) ++digits;
+        --exp10;
+      }
+    }
+  }
+  if( !any ) {
+    // nan, inf or no number at all
+    char *end = NULL;
+    double val = strtod( str, &end );
+    if( end == str ) return -1;
+    *pval = val;
+    return 0;
+  }
+  if( 'e' == *p || 'E' == *p ) {
+    const char *q = p + 1;
+    bool eneg = ( '-' == *q );
+    if( '-' == *q || '+' == *q ) ++q;
+    if( *q >= '0' && *q <= '9' ) {
+      int e = 0;
+      for( ; *q >= '0' && *q <= '9'; ++q ) if( e < 10000 ) e = e * 10 + ( *q - '0' );
+      exp10 += eneg ? -e : e;
+    }
+  }
+  if( digits > 15 || exp10 < -22 || exp10 > 22 ) {
+    *pval = strtod( str, NULL );
+    return 0;
+  }
+  double val = (double)mant;
+  val = ( exp10 < 0 ) ? val / pow10[ -exp10 ] : val * pow10[ exp10 ];
+  *pval = neg ? -val : val;
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Parse an unsigned integer
+//! @param [in]  str   Value cstring from isegHAL
+//! @param [out] pval  Parsed value
+//! @return      0 on success, -1 if the cstring doesn't start with a number
+//!
+//! Locale-free replacement of sscanf( "%u" ), negative numbers are
+//! returned in two's complement like sscanf does.
+//------------------------------------------------------------------------------
+int devIsegHalParseUInt32( const char *str, epicsUInt32 *pval ) {
+  const char *p = str;
+  while( ' ' == *p || '\t' == *p ) ++p;
+  bool neg = ( '-' == *p );
+  if( '-' == *p || '+' == *p ) ++p;
+  if( *p < '0' || *p > '9' ) return -1;
+  epicsUInt32 val = 0;
+  for( ; *p >= '0' && *p <= '9'; ++p ) val = val * 10 + ( *p - '0' );
+  *pval = neg ? 0u - val : val;
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Set the value of a record
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @param [in]  value  Value cstring of the item
+//!
+//! The value is parsed once into the value slot, the record only copies
+//! the slot when it is processed.
+//------------------------------------------------------------------------------
+static void isegStoreValue( devIsegHal_info_t *pinfo, const char* value ) {
+  isegCopyValue( pinfo, pinfo->value, value );
+  switch( pinfo->vtype ) {
+    case ISEG_VALUE_DOUBLE:
+      pinfo->vvalid = ( 0 == devIsegHalParseDouble( pinfo->value, &pinfo->num.f64 ) );
+      break;
+    case ISEG_VALUE_UINT:
+      pinfo->vvalid = ( 0 == devIsegHalParseUInt32( pinfo->value, &pinfo->num.u32 ) );
+      break;
+    default:
+      pinfo->vvalid = false;
+      break;
+  }
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Check if the value of a record differs from the shadow copy
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @return      false if only other bits of the item have been changed, or
+//!              if the value moved less than the deadband of the record
+//!
+//! The deadband is checked against the value the record has last been
+//! updated with, so that slow drifts are delivered as well.
+//------------------------------------------------------------------------------
+static bool isegValueChanged( devIsegHal_info_t const* pinfo ) {
+  if( pinfo->stale ) return true;
+  if( pinfo->bit >= 0 ) {
+    char value[VALUE_SIZE];
+    isegCopyValue( pinfo, value, pinfo->pcache->value );
+    return ( value[0] != pinfo->value[0] );
+  }
+  if( pinfo->deadband <= 0. || !pinfo->vvalid ) return true;
+
+  epicsFloat64 last, value;
+  if( ISEG_VALUE_DOUBLE == pinfo->vtype ) {
+    last = pinfo->num.f64;
+    if( 0 != devIsegHalParseDouble( pinfo->pcache->value, &value ) ) return true;
+  } else {
+    epicsUInt32 buffer = 0;
+    last = pinfo->num.u32;
+    if( 0 != devIsegHalParseUInt32( pinfo->pcache->value, &buffer ) ) return true;
+    value = buffer;
+  }
+  epicsFloat64 limit = pinfo->relative ? pinfo->deadband * fabs( last ) : pinfo->deadband;
+  return ( fabs( value - last ) > limit );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Check if the shadow copy of an item is newer than a record
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @return      true if the record has to be updated
+//------------------------------------------------------------------------------
+static bool isegCacheNewer( devIsegHal_info_t const* pinfo ) {
+  isegCacheEntry const* entry = pinfo->pcache;
+  if( strcmp( entry->quality, ISEG_ITEM_QUALITY_OK ) != 0 ) return false;
+  if( pinfo->stale && entry->refreshed > 0. ) return true; // verified value from isegHAL
+  return ( pinfo->time.secPastEpoch != entry->time.secPastEpoch || pinfo->time.nsec != entry->time.nsec );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Update a record subscribed to a changed item
+//! @param [in]  pinfo  Address of the record's private data structure
+//!
+//! Records with pending requests are skipped, they are updated by their
+//! own request or with the next poll.
+//------------------------------------------------------------------------------
+void isegHalWorker::deliverUpdate( devIsegHal_info_t* pinfo ) {
+  int pending;
+  do {
+    pending = epicsAtomicGetIntT( &pinfo->inflight );
+    if( pending & ( ISEG_INFLIGHT_READ | ISEG_INFLIGHT_CALLBACK | ISEG_INFLIGHT_WRITE ) ) return;
+    if( !isegCacheNewer( pinfo ) ) return;
+    if( !isegValueChanged( pinfo ) ) {
+      // other bits of the item changed or change within the deadband,
+      // only the time of the last refresh is kept
+      pinfo->time = pinfo->pcache->time;
+      return;
+    }
+  } while( epicsAtomicCmpAndSwapIntT( &pinfo->inflight, pending, pending | ISEG_INFLIGHT_CALLBACK ) != pending );
+
+  isegStoreValue( pinfo, pinfo->pcache->value );
+  pinfo->time = pinfo->pcache->time;
+  deliver( pinfo );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Deliver an update to a record
+//! @param [in]  pinfo  Address of the record's private data structure
+//!
+//! Records scanned on I/O Intr are marked and processed by the scan of
+//! their channel or module, which is issued by requestScans. Output records are
+//! processed with their readback via callback.
+//------------------------------------------------------------------------------
+void isegHalWorker::deliver( devIsegHal_info_t* pinfo ) {
+  pinfo->pflag = P_IO_INTR;
+  if( !pinfo->intr ) {
+    isegComplete( pinfo );
+    return;
+  }
+  int pending;
+  do {
+    pending = epicsAtomicGetIntT( &pinfo->inflight );
+  } while( epicsAtomicCmpAndSwapIntT( &pinfo->inflight, pending, pending | ISEG_INFLIGHT_UPDATE ) != pending );
+  if( !pinfo->pscan->queued ) {
+    pinfo->pscan->queued = true;
+    _scans.push_back( pinfo->pscan );
+  }
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Issue the I/O Intr scans of all channels and modules with updated records
+//!
+//! Called when the queue of the worker is empty or after ISEG_SCAN_BATCH
+//! requests, so that updates of several items of a channel are processed
+//! by one scan.
+//------------------------------------------------------------------------------
+void isegHalWorker::requestScans() {
+  _handled = 0;
+  std::vector< isegScanGroup* >::iterator it = _scans.begin();
+  for( ; it != _scans.end(); ++it ) {
+    (*it)->queued = false;
+    scanIoRequest( (*it)->ioscanpvt );
+  }
+  _scans.clear();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Read an item from isegHAL
+//! @param [in]  pinfo  Address of the record's private data structure
+//!
+//! Records processed normally are always called back, records registered
+//! to the polling thread only if the value has been updated in isegHAL.
+//! All read requests joined while this one was pending are served by
+//! the same call to isegHAL.
+//! Changes are detected once per item by the shadow copy in isegHalCache,
+//! all other polled records of the item are updated as well. Polls of an
+//! item read less than ISEG_CACHE_MAXAGE ago are served from the cache.
+//------------------------------------------------------------------------------
+void isegHalWorker::getItem( devIsegHal_info_t* _pdata ) {
+  if( _pdata->parray ) {
+    getArray( _pdata );
+    return;
+  }
+  // request has already been served from another lane
+  int requested = epicsAtomicGetIntT( &_pdata->inflight );
+  if( !( requested & ( ISEG_INFLIGHT_POLL | ISEG_INFLIGHT_READ ) ) ) return;
+
+  isegCacheEntry* entry = _pdata->pcache;
+  double now = isegMonotonicNow();
+  IsegItem item;
+  bool read = ( requested & ISEG_INFLIGHT_READ ) || ( now - entry->refreshed >= ISEG_CACHE_MAXAGE );
+  bool changed = false;
+  if( read ) {
+    item = iseg_getItem( _session.c_str(), _pdata->object );
+    changed = isegHalCache::instance().update( entry, item, now );
+  }
+
+  // Take the pending requests, the record stays marked while it is
+  // processed with the result
+  int pending, next;
+  bool newer;
+  do {
+    pending = epicsAtomicGetIntT( &_pdata->inflight );
+    next = pending & ( ISEG_INFLIGHT_CALLBACK | ISEG_INFLIGHT_WRITE );
+    // a pending write will update the record anyway
+    newer = !( pending & ( ISEG_INFLIGHT_WRITE | ISEG_INFLIGHT_CALLBACK ) ) && isegCacheNewer( _pdata );
+    if( ( pending & ISEG_INFLIGHT_READ ) && !read ) newer = false; // joined after check, served below
+    if( newer && !isegValueChanged( _pdata ) ) {
+      // other bits of the item changed or change within the deadband,
+      // only the time of the last refresh is kept
+      _pdata->time = entry->time;
+      newer = false;
+    }
+    if( ( pending & ISEG_INFLIGHT_READ ) || newer ) next |= ISEG_INFLIGHT_CALLBACK;
+  } while( epicsAtomicCmpAndSwapIntT( &_pdata->inflight, pending, next ) != pending );
+
+  if( pending & ISEG_INFLIGHT_READ ) {
+    if( !read ) {
+      item = iseg_getItem( _session.c_str(), _pdata->object );
+      changed = isegHalCache::instance().update( entry, item, now );
+    }
+    memcpy( _pdata->quality, item.quality,  QUALITY_SIZE );
+    isegStoreValue( _pdata, item.value );
+    _pdata->time = entry->time; // decoded by the cache update
+    _pdata->pflag = P_ASYNC;
+    isegComplete( _pdata );
+  } else if( newer ) {
+    // value was updated in isegHAL
+    isegStoreValue( _pdata, entry->value );
+    _pdata->time = entry->time;
+    deliver( _pdata );
+  }
 
-        if ( iseg_setItem( _pdata->interface, "Configuration", "0" ) != ISEG_OK ) {
-          fprintf( stderr, "\033[31;1m%s Error while writing configuration '%s'\033[0m\n", _pdata->interface,_pdata->object );
-          _pdata->ioStatus = ISEG_ERROR;
-          continue;
+  if( !changed ) return;
+  std::vector< devIsegHal_info_t* >::iterator it = entry->subscribers.begin();
+  for( ; it != entry->subscribers.end(); ++it ) {
+    if( (*it) != _pdata && (*it)->polled ) deliverUpdate( *it );
+  }
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Read the item of all channels of a module from isegHAL
+//! @param [in]  pinfo  Address of the array record's private data structure
+//!
+//! The channel items are read back-to-back, the record is called back
+//! once with the values of all channels and the newest timestamp. Polls
+//! are served from the cache for channels read less than
+//! ISEG_CACHE_MAXAGE ago (e.g. by scalar records of the same item), the
+//! polled scalar records of changed channels are updated as well.
+//------------------------------------------------------------------------------
+void isegHalWorker::getArray( devIsegHal_info_t* _pdata ) {
+  // request has already been served from another lane
+  int requested = epicsAtomicGetIntT( &_pdata->inflight );
+  if( !( requested & ( ISEG_INFLIGHT_POLL | ISEG_INFLIGHT_READ ) ) ) return;
+
+  isegArray* parray = _pdata->parray;
+  double now = isegMonotonicNow();
+  bool force = ( requested & ISEG_INFLIGHT_READ );
+  const char* quality = ISEG_ITEM_QUALITY_OK;
+  unsigned long changes = 0;
+  epicsTimeStamp time = { 0, 0 };
+  std::vector< isegCacheEntry* >::iterator entry = parray->entries.begin();
+  for( ; entry != parray->entries.end(); ++entry ) {
+    if( force || now - (*entry)->refreshed >= ISEG_CACHE_MAXAGE ) {
+      IsegItem item = iseg_getItem( _session.c_str(), (*entry)->object );
+      if( isegHalCache::instance().update( *entry, item, now ) ) {
+        std::vector< devIsegHal_info_t* >::iterator it = (*entry)->subscribers.begin();
+        for( ; it != (*entry)->subscribers.end(); ++it ) {
+          if( (*it)->polled ) deliverUpdate( *it );
         }
+      }
+    }
+    if( strcmp( (*entry)->quality, ISEG_ITEM_QUALITY_OK ) != 0 ) quality = (*entry)->quality;
+    changes += (*entry)->changes;
+    if( epicsTimeLessThan( &time, &(*entry)->time ) ) time = (*entry)->time;
+  }
 
-        _pdata->pflag = P_ASYNC; // Normal processing write always async
-        epicsTimeGetCurrent( &_pdata->time ); // get time after successful write to device
-        callbackRequest( _pdata->pcallback );
-        break;
+  // Take the pending requests, the record stays marked while it is
+  // processed with the result
+  int pending, next;
+  bool newer;
+  do {
+    pending = epicsAtomicGetIntT( &_pdata->inflight );
+    next = pending & ( ISEG_INFLIGHT_CALLBACK | ISEG_INFLIGHT_WRITE );
+    newer = !( pending & ( ISEG_INFLIGHT_WRITE | ISEG_INFLIGHT_CALLBACK ) )
+            && 0 == strcmp( quality, ISEG_ITEM_QUALITY_OK )
+            && ( _pdata->stale || changes != parray->changes );
+    if( ( pending & ISEG_INFLIGHT_READ ) || newer ) next |= ISEG_INFLIGHT_CALLBACK;
+  } while( epicsAtomicCmpAndSwapIntT( &_pdata->inflight, pending, next ) != pending );
+  if( !( pending & ISEG_INFLIGHT_READ ) && !newer ) return;
+
+  {
+    epicsGuard< epicsMutex > guard( parray->lock );
+    for( size_t i = 0; i < parray->entries.size(); ++i )
+      devIsegHalParseDouble( parray->entries[i]->value, &parray->values[i] );
+  }
+  parray->changes = changes;
+  strncpy( _pdata->quality, quality, QUALITY_SIZE );
+  _pdata->time = time;
+  if( pending & ISEG_INFLIGHT_READ ) {
+    _pdata->pflag = P_ASYNC;
+    isegComplete( _pdata );
+  } else {
+    deliver( _pdata );
+  }
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Check the EventStatus words of a module
+//! @param [in]  pgroup  Address of the watched module
+//!
+//! The EventStatus records are updated with the words as read. If a bit
+//! has been set since the previous check, all items of the module or
+//! channel are read immediately. The events stay latched for the EventStatus
+//! records of the operator, unless clearing has been requested. Then the
+//! events of the module are cleared with its doClear bit and each set bit
+//! is a new event.
+//------------------------------------------------------------------------------
+void isegHalWorker::checkEvents( isegEventGroup* pgroup ) {
+  bool any = false;
+  double now = isegMonotonicNow();
+  std::vector< isegEventWord >::iterator word = pgroup->words.begin();
+  for( ; word != pgroup->words.end(); ++word ) {
+    IsegItem item = iseg_getItem( _session.c_str(), word->status.c_str() );
+    if( strcmp( item.quality, ISEG_ITEM_QUALITY_OK ) != 0 ) continue;
+
+    // show the word in the registered EventStatus records, before it may be cleared
+    if( word->pstatus && isegHalCache::instance().update( word->pstatus, item, now ) ) {
+      std::vector< devIsegHal_info_t* >::iterator it = word->pstatus->subscribers.begin();
+      for( ; it != word->pstatus->subscribers.end(); ++it ) {
+        if( (*it)->polled ) deliverUpdate( *it );
       }
-      default:
-      break;
     }
+
+    epicsUInt32 bits = strtoul( item.value, NULL, 0 );
+    epicsUInt32 fresh = bits & ~word->last;
+    word->last = pgroup->autoClear ? 0 : bits;
+    if( 0 == fresh ) continue;
+    any = true;
+    word->events++;
+    std::vector< devIsegHal_info_t* >::iterator it = word->members.begin();
+    for( ; it != word->members.end(); ++it ) {
+      // don't serve this read from the cache
+      if( (*it)->parray ) {
+        std::vector< isegCacheEntry* >& entries = (*it)->parray->entries;
+        for( size_t i = 0; i < entries.size(); ++i ) entries[i]->refreshed = 0.;
+      } else {
+        (*it)->pcache->refreshed = 0.;
+      }
+      isegRequestRead( *it, ISEG_INFLIGHT_POLL, true );
+    }
+  }
+  if( any && pgroup->autoClear ) {
+    if( iseg_setItem( _session.c_str(), pgroup->clear.c_str(), "1" ) != ISEG_OK ) {
+      fprintf( stderr, "\033[31;1mError while clearing events '%s'\033[0m\n", pgroup->clear.c_str() );
+    }
+  }
+  epicsAtomicSetIntT( &pgroup->inflight, 0 );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Write an item to isegHAL
+//! @param [in]  pinfo  Address of the record's private data structure
+//!
+//! The value is taken from the write slot of the record. If the slot has
+//! been updated while writing, the newer value is written as well.
+//------------------------------------------------------------------------------
+void isegHalWorker::setItem( devIsegHal_info_t* _pdata ) {
+  if( _pdata->parray ) {
+    setArray( _pdata );
+    return;
   }
+  char _value[VALUE_SIZE];
+  epicsUInt32 seq;
+  do {
+    seq = isegTakeWrite( _pdata, _value );
+    _pdata->ioStatus = ISEG_OK;
+    std::cout << " write request "<< _value << " run from thread: " << epicsThreadGetNameSelf() << std::endl;
+    if( iseg_setItem( _session.c_str(), _pdata->object, _value ) != ISEG_OK ) {
+      fprintf( stderr, "\033[31;1m%s Error while writing value '%s': '%s'\033[0m\n", _pdata->interface, _pdata->object, _value );
+      _pdata->ioStatus = ISEG_ERROR;
+    }
+  } while( !isegCompleteWrite( _pdata, seq ) );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Write the item of all channels of a module to isegHAL
+//! @param [in]  pinfo  Address of the array record's private data structure
+//!
+//! The values are written back-to-back, the record is called back once
+//! after all channels have been written. Channels beyond the values
+//! (NORD of the record) are not written. Negative values of UI items are
+//! rejected, the record gets a WRITE alarm.
+//------------------------------------------------------------------------------
+void isegHalWorker::setArray( devIsegHal_info_t* _pdata ) {
+  std::vector< isegCacheEntry* > const& entries = _pdata->parray->entries;
+  std::vector< epicsFloat64 > values;
+  char _value[VALUE_SIZE];
+  epicsUInt32 seq;
+  do {
+    seq = isegTakeWrite( _pdata, _value, &values );
+    _pdata->ioStatus = ISEG_OK;
+    for( size_t i = 0; i < values.size() && i < entries.size(); ++i ) {
+      if( ISEG_VALUE_DOUBLE == _pdata->vtype ) {
+        snprintf( _value, VALUE_SIZE, "%.17g", values[i] );
+      } else if( !( values[i] >= 0. && values[i] <= (epicsFloat64)UINT_MAX ) ) { // also NaN
+        fprintf( stderr, "\033[31;1m%s Value %g out of range for '%s'\033[0m\n", _pdata->interface, values[i], entries[i]->object );
+        _pdata->ioStatus = ISEG_ERROR;
+        continue;
+      } else {
+        snprintf( _value, VALUE_SIZE, "%lu", (unsigned long)( values[i] + 0.5 ) );
+      }
+      if( iseg_setItem( _session.c_str(), entries[i]->object, _value ) != ISEG_OK ) {
+        fprintf( stderr, "\033[31;1m%s Error while writing value '%s': '%s'\033[0m\n", _pdata->interface, entries[i]->object, _value );
+        _pdata->ioStatus = ISEG_ERROR;
+      }
+    }
+  } while( !isegCompleteWrite( _pdata, seq ) );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Write a broadcast command to isegHAL
+//! @param [in]  pinfo  Address of the record's private data structure
+//!
+//! The value is taken from the write slot of the record. The record is
+//! completed in any case, so it does not stay active after an error.
+//------------------------------------------------------------------------------
+void isegHalWorker::setItemGlobal( devIsegHal_info_t* _pdata ) {
+  const char* _name = _session.c_str();
+  char _value[VALUE_SIZE];
+  epicsUInt32 seq;
+  do {
+    seq = isegTakeWrite( _pdata, _value );
+    _pdata->ioStatus = ISEG_OK;
+    if ( iseg_setItem( _name, "Configuration", "1" ) != ISEG_OK ) {
+      fprintf( stderr, "\033[31;1m%s Error while writing configuration '%s'\033[0m\n", _pdata->interface,_pdata->object );
+      iseg_setItem( _name, "Configuration", "0"); // Restore function
+      _pdata->ioStatus = ISEG_ERROR;
+    } else if ( iseg_setItem( _name, _pdata->object, _value ) != ISEG_OK ) {
+      fprintf( stderr, "\033[31;1m%s Error while writing value '%s': '%s'\033[0m\n", _pdata->interface,_pdata->object, _value );
+      iseg_setItem( _name, "Configuration", "0"); // Restore function
+      _pdata->ioStatus = ISEG_ERROR;
+    } else if ( iseg_setItem( _name, "Configuration", "0" ) != ISEG_OK ) {
+      fprintf( stderr, "\033[31;1m%s Error while writing configuration '%s'\033[0m\n", _pdata->interface,_pdata->object );
+      _pdata->ioStatus = ISEG_ERROR;
+    }
+  } while( !isegCompleteWrite( _pdata, seq ) );
 }
+
+//------------------------------------------------------------------------------
+//! @brief       Create and start the worker threads
+//! @return      false if no worker could be created
+//!
+//! Each worker connects its own session "<name>_MOD[<index>]" to the
+//! interface which has been connected via isegHalConnect.
+//! A record has at most one write queued, so the write lane of each worker
+//! is extended to hold a write of each of its records and the close request.
+//------------------------------------------------------------------------------
 bool isegInitWorkers() {
-    std::cout << "Initializating Message Queue Worker Thread (" << __FUNCTION__ << ") thread id: " << epicsThreadGetNameSelf() << std::endl;
+  std::cout << "Initializating Message Queue Worker Threads (" << __FUNCTION__ << ") thread id: " << epicsThreadGetNameSelf() << std::endl;
+
+  isegHalConnectionHandler& handler = isegHalConnectionHandler::instance();
+  size_t interfaces = handler.numInterfaces();
+  for( size_t n = 0; n < interfaces; ++n ) {
+    std::string name = handler.getName( n );
+    std::string interface = handler.getHalInterface( n );
+    for( unsigned i = 0; i < isegNumWorkers; ++i ) {
+      std::ostringstream session;
+      session << name << "_MOD";
+      if( i > 0 ) session << i;
+      unsigned depths[ NUM_LANES ];
+      memcpy( depths, isegLaneDepth, sizeof( depths ) );
+      size_t index = isegWorkers.size();
+      if( index < isegWriters.size() && depths[ LANE_WRITE ] <= isegWriters[ index ] )
+        depths[ LANE_WRITE ] = isegWriters[ index ] + 1;
+      isegHalWorker* worker = new isegHalWorker( index, session.str(), interface, depths );
+      isegWorkers.push_back( worker );
+      worker->thread.start();
+    }
+  }
+  // wait until the sessions of the workers provide data
+  for( size_t i = 0; i < isegWorkers.size(); ++i ) {
+    if( !isegWorkers[i]->waitReady( ISEG_READY_TIMEOUT + 1. ) )
+      fprintf( stderr, "\033[31;1mWorker %lu not ready\033[0m\n", (unsigned long)i );
+  }
+  std::cout << "(" << __FUNCTION__ << ") started " << isegWorkers.size() << " worker(s), called by thread id: " << epicsThreadGetNameSelf() << std::endl;
+  return !isegWorkers.empty();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Create and start the dispatcher threads
+//!
+//! With 0 dispatcher threads the records are processed by EPICS callbacks.
+//------------------------------------------------------------------------------
+static void isegInitDispatchers() {
+  for( unsigned i = 0; i < isegNumDispatchers; ++i ) {
+    isegHalDispatcher* dispatcher = new isegHalDispatcher( i, isegDispatchPriority );
+    isegDispatchers.push_back( dispatcher );
+    dispatcher->thread.start();
+  }
+  std::cout << "(" << __FUNCTION__ << ") started " << isegDispatchers.size() << " dispatcher(s) with priority "
+            << isegDispatchPriority << std::endl;
+}
 
-    /* Create a new message queue for this port*/
-    isegClientQueue = epicsMessageQueueCreate(RECV_Q_SIZE, sizeof(devIsegHal_queue_t));
-    if (isegClientQueue == NULL) return false;
-    /*  std::cout << "message queue created(" << __FUNCTION__ << ") called by thread id: " << epicsThreadGetNameSelf() << std::endl;*/
+//------------------------------------------------------------------------------
+//! @brief       Report the throughput of the dispatcher threads
+//! @param [in]  period   Time since the last report [s]
+//! @param [in]  verbose  Print the throughput, otherwise only overflows
+//------------------------------------------------------------------------------
+static void isegDispatchReport( double period, bool verbose ) {
+  static size_t lastCompleted = 0;
+  static size_t lastBatches = 0;
+  static size_t lastOverflows = 0;
+  if( isegDispatchers.empty() ) return;
+
+  size_t completed = 0;
+  size_t batches = 0;
+  for( size_t i = 0; i < isegDispatchers.size(); ++i ) {
+    completed += isegDispatchers[i]->completed();
+    batches += isegDispatchers[i]->batches();
+  }
+  size_t overflows = epicsAtomicGetSizeT( &isegDispatchOverflows );
+  if( verbose ) {
+    double records = completed - lastCompleted;
+    printf( "isegHalThread::run: %lu dispatcher(s): %.0f records/s completed, %.1f records per batch\n",
+            (unsigned long)isegDispatchers.size(), records / period,
+            ( batches > lastBatches ) ? records / ( batches - lastBatches ) : 0. );
+  }
+  if( overflows != lastOverflows ) {
+    fprintf( stderr, "\033[31;1mWarning: dispatcher queue overflow, %lu records completed by EPICS callbacks.\033[0m\n",
+             (unsigned long)( overflows - lastOverflows ) );
+  }
+  lastCompleted = completed;
+  lastBatches = batches;
+  lastOverflows = overflows;
+}
 
-    if (epicsThreadCreate("isegACtrlTask", epicsThreadPriorityHigh, epicsThreadGetStackSize(epicsThreadStackMedium),
-        (EPICSTHREADFUNC)isegMgtTask, NULL) == 0) return false;
-    epicsThreadSleep(2);
-    std::cout << "(" << __FUNCTION__ << ") function called by thread id: " << epicsThreadGetNameSelf() << std::endl;
-    return true;
+//------------------------------------------------------------------------------
+//! @brief       Stop the polling thread and close the sessions of the workers
+//!
+//! Called at exit. Queued writes are still sent to isegHAL, as the close
+//! request is queued behind them in the write lane. Waits at most
+//! ISEG_SHUTDOWN_TIMEOUT for the workers. The dispatcher threads are
+//! stopped afterwards.
+//------------------------------------------------------------------------------
+static void isegShutdown( void* ) {
+  static bool done = false;
+  if( done || isegWorkers.empty() ) return;
+  done = true;
+
+  if( !myIsegHalThread->stop( ISEG_SHUTDOWN_TIMEOUT ) )
+    fprintf( stderr, "\033[31;1mPolling thread did not stop\033[0m\n" );
+
+  std::vector< isegHalWorker* >::iterator it = isegWorkers.begin();
+  for( ; it != isegWorkers.end(); ++it ) {
+    if( !(*it)->request( NULL, CLOSE_CONN, LANE_WRITE ) ) {
+      fprintf( stderr, "\033[31;1m: isegHal Mgt Queue Overflowed \033[0m\n" );
+    }
+  }
+  epicsTimeStamp start, now;
+  epicsTimeGetCurrent( &start );
+  for( it = isegWorkers.begin(); it != isegWorkers.end(); ++it ) {
+    epicsTimeGetCurrent( &now );
+    double left = ISEG_SHUTDOWN_TIMEOUT - epicsTimeDiffInSeconds( &now, &start );
+    if( !(*it)->waitDone( left > 0. ? left : 0. ) )
+      fprintf( stderr, "\033[31;1mSession %s not closed in time\033[0m\n", (*it)->getSession().c_str() );
+  }
+  for( size_t i = 0; i < isegDispatchers.size(); ++i ) isegDispatchers[i]->stop();
 }
 
 //------------------------------------------------------------------------------
@@ -405,21 +1518,113 @@ long devIsegHalInit( int after ) {
     firstRunBefore = false;
     // create polling thread
             myIsegHalThread = new isegHalThread();
+    for( unsigned i = 0; i < NUM_POLL_CLASSES; ++i )
+      myIsegHalThread->changeIntervall( isegPollIntervall[i], (devIsegHal_poll_t)i );
+    myIsegHalThread->setDbgLvl( isegDebug );
+    myIsegHalThread->setEventMode( isegEventMode );
+    myIsegHalThread->changeEventIntervall( isegEventIntervall );
+    // read the items of all records in parallel, if enabled
+    isegHalPrefetch::instance().run();
 
     } else {
-        std::string const& _name_ = isegHalConnectionHandler::instance().getName();
-        isegHalConnectionHandler::instance().disconnect(_name_) ;
-
         static bool firstRunAfter = true;
     if ( !firstRunAfter ) return 0;
       firstRunAfter = false;
-      // Initialise workers
+      isegHalPrefetch::instance().clear();
+      // records are initialized, the workers use their own sessions
+      isegHalConnectionHandler& handler = isegHalConnectionHandler::instance();
+      for( size_t n = 0; n < handler.numInterfaces(); ++n ) handler.disconnect( handler.getName( n ) );
+      // Initialise dispatchers and workers
+      isegInitDispatchers();
       isegInitWorkers();
       // start thread
       myIsegHalThread->thread.start();
+      epicsAtExit( isegShutdown, NULL );
   }
   return OK;
 }
+//------------------------------------------------------------------------------
+//! @brief       Get the number of channels of a module
+//! @param [in]  interface  Name of the interface
+//! @param [in]  module     "<line>.<module>"
+//! @return      Number of channels, 0 if unknown
+//!
+//! The ChannelNumber item is read once per module. Must only be called
+//! during record initialization.
+//------------------------------------------------------------------------------
+static epicsUInt32 isegChannelsOf( const char* interface, std::string const& module ) {
+  static std::map< std::string, epicsUInt32 > channels;
+
+  std::string key = std::string( interface ) + ":" + module;
+  std::map< std::string, epicsUInt32 >::iterator it = channels.find( key );
+  if( it != channels.end() ) return it->second;
+
+  std::string object = module + ".ChannelNumber";
+  IsegItem item = EmptyIsegItem;
+  if( !isegHalPrefetch::instance().take( interface, object, item ) )
+    item = iseg_getItem( interface, object.c_str() );
+  epicsUInt32 count = 0;
+  if( strcmp( item.quality, ISEG_ITEM_QUALITY_OK ) != 0 || 0 != devIsegHalParseUInt32( item.value, &count ) ) {
+    fprintf( stderr, "\033[31;1mError while reading '%s' from interface '%s' (Q: %s)\033[0m\n", object.c_str(), interface, item.quality );
+    count = 0;
+  }
+  channels[ key ] = count;
+  return count;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Collect the channel items of an array record
+//! @param [in]  pinfo    Address of the record's private data structure,
+//!                       initialized with channel 0
+//! @param [in]  pattern  Object name with channel wildcard (<line>.<module>.*.<item>)
+//! @param [in]  nelm     Max. number of elements of the record
+//! @return      Address of the array
+//!
+//! The channels are numbered from 0, the array ends with the last channel
+//! of the module (ChannelNumber) or with NELM. All channels of a module
+//! have the properties of channel 0. Values are only read for items not
+//! yet used by other records.
+//------------------------------------------------------------------------------
+static isegArray* isegInitArray( devIsegHal_info_t *pinfo, std::string const& pattern, epicsUInt32 nelm ) {
+  size_t star = pattern.find( ".*." );
+  std::string prefix = pattern.substr( 0, star + 1 );
+  std::string name = pattern.substr( star + 2 );
+
+  epicsUInt32 count = isegChannelsOf( pinfo->interface, pattern.substr( 0, star ) );
+  if( 0 == count ) count = 1; // at least channel 0, which has been checked
+  if( count > nelm ) count = nelm;
+
+  isegArray *parray = new isegArray;
+  parray->entries.push_back( pinfo->pcache );
+  for( epicsUInt32 i = 1; i < count; ++i ) {
+    std::ostringstream object;
+    object << prefix << i << name;
+    isegCacheEntry* entry = isegHalCache::instance().find( pinfo->interface, object.str() );
+    if( !entry ) {
+      IsegItem item = EmptyIsegItem;
+      if( !isegHalPrefetch::instance().take( pinfo->interface, object.str(), item ) )
+        item = iseg_getItem( pinfo->interface, object.str().c_str() );
+      if( strcmp( item.quality, ISEG_ITEM_QUALITY_OK ) != 0 ) {
+        fprintf( stderr, "\033[31;1mError while reading value '%s' from interface '%s' (Q: %s)\033[0m\n",
+                 object.str().c_str(), pinfo->interface, item.quality );
+        memset( item.object, 0, FULLY_QUALIFIED_OBJECT_SIZE );
+        strncpy( item.object, object.str().c_str(), FULLY_QUALIFIED_OBJECT_SIZE - 1 );
+      }
+      entry = isegHalCache::instance().subscribe( pinfo->interface, item, NULL );
+    }
+    parray->entries.push_back( entry );
+  }
+
+  parray->values.assign( parray->entries.size(), 0. );
+  parray->changes = 0;
+  for( size_t i = 0; i < parray->entries.size(); ++i ) {
+    devIsegHalParseDouble( parray->entries[i]->value, &parray->values[i] );
+    parray->changes += parray->entries[i]->changes;
+    if( epicsTimeLessThan( &pinfo->time, &parray->entries[i]->time ) ) pinfo->time = parray->entries[i]->time;
+  }
+  return parray;
+}
+
 //------------------------------------------------------------------------------
 //! @brief       Common initialization of the record
 //! @param [in]  prec       Address of the record calling this function
@@ -449,6 +1654,41 @@ long devIsegHalInitRecord( dbCommon *prec, const devIsegHal_rec_t *pconf ) {
       return ERROR;
   }
 
+  // Item of all channels of a module: "@<line>.<module>.*.<item> <Interface>"
+  // Array records are checked against the item of channel 0
+  std::string pattern;
+  size_t star = options.at(0).find( ".*." );
+  if( std::string::npos != star ) {
+    if( 0 == pconf->nelm ) {
+      std::cerr << prec->name << ": Channel wildcard '*' is only supported by array records" << std::endl;
+      return ERROR;
+    }
+    pattern = options.at(0);
+    options.at(0).replace( star + 1, 1, "0" );
+  }
+
+  // Single bit of an item: "@<isegItem>:<bit> <Interface>"
+  // bi records read the whole item and take the bit from the shadow copy,
+  // so all bits of an item are served by one read. Other records pass
+  // the bit on to isegHAL (e.g. "Control:6" of bo records).
+  int bit = -1;
+  const char* type = pconf->type;
+  size_t colon = options.at(0).rfind( ':' );
+  if( std::string::npos != colon
+      && 0 == strcmp( pconf->type, "BOOL" ) && NULL == strchr( pconf->access, 'W' ) ) {
+    char *end = NULL;
+    const char *pbit = options.at(0).c_str() + colon + 1;
+    long n = strtol( pbit, &end, 10 );
+    if( end == pbit || '\0' != *end || n < 0 || n > 31 ) {
+      std::cerr << prec->name << ": Invalid INP field: " << ss.str() << "\n"
+            << "    Syntax is \"@<isegItem>:<bit> <Interface>\"" << std::endl;
+      return ERROR;
+    }
+    bit = n;
+    type = "UI";
+    options.at(0).erase( colon );
+  }
+
   // Test if interface is connected to isegHAL server
   if( !isegHalConnectionHandler::instance().connected( options.at(1) ) ) {
     std::cerr << "\033[31;1m" << "isegHal interface " << options.at(1) << " not connected!"
@@ -456,7 +1696,13 @@ long devIsegHalInitRecord( dbCommon *prec, const devIsegHal_rec_t *pconf ) {
     return ERROR;
   }
 
-  IsegItemProperty isegItem = iseg_getItemProperty( options.at(1).c_str(), options.at(0).c_str() );
+  // warm restart: properties and last known value from the on-disk cache
+  IsegItemProperty isegItem;
+  IsegItem item = EmptyIsegItem;
+  bool warm = pattern.empty() && isegHalDiskCache::instance().lookup( options.at(1), options.at(0), isegItem, item );
+
+  // properties are shared by all records of an item on the same module type
+  if( !warm ) isegItem = isegHalCache::instance().property( options.at(1), options.at(0) );
   if( strcmp( isegItem.quality, ISEG_ITEM_QUALITY_OK ) != 0 ) {
     fprintf( stderr, "\033[31;1m%s: Error while reading item property '%s' (Q: %s)\033[0m\n",
         prec->name, options.at(0).c_str(), isegItem.quality );
@@ -472,7 +1718,7 @@ long devIsegHalInitRecord( dbCommon *prec, const devIsegHal_rec_t *pconf ) {
       return ERROR;
     }
   }
-  if ( strncmp( isegItem.type, pconf->type, strlen( pconf->type ) ) != 0 ) {
+  if ( strncmp( isegItem.type, type, strlen( type ) ) != 0 || ( !pattern.empty() && 'S' == isegItem.type[0] ) ) {
     fprintf( stderr, "\033[31;1m%s: DataType '%s' of '%s' not supported by this record!\033[0m\n",
           prec->name, isegItem.type, isegItem.object );
     return ERROR;
@@ -484,37 +1730,66 @@ long devIsegHalInitRecord( dbCommon *prec, const devIsegHal_rec_t *pconf ) {
   memcpy( pinfo->unit,   isegItem.unit,   UNIT_SIZE );
   pinfo->pcallback = NULL;  // just to be sure
   pinfo->ioStatus = ISEG_OK;
+  pinfo->bit = bit;
+  pinfo->inflight = 0;
+  pinfo->wvalue[0] = 0;
+  pinfo->wseq = 0;
+  pinfo->wlock = epicsMutexMustCreate();
+  pinfo->coalesce = strchr( pconf->access, 'W' ) && isegInfoFlag( prec, "isegCoalesce" );
+  pinfo->pollClass = isegPollClassOf( prec );
+  pinfo->polled = false;
+  pinfo->pollGen = 0;
+  pinfo->evented = false;
+  pinfo->regIndex = -1;
+  pinfo->stale = warm;
+  switch( isegItem.type[0] ) {
+    case 'R': pinfo->vtype = ISEG_VALUE_DOUBLE; break;
+    case 'S': pinfo->vtype = ISEG_VALUE_STRING; break;
+    default:  pinfo->vtype = ISEG_VALUE_UINT;   break;
+  }
+  if( bit >= 0 ) pinfo->vtype = ISEG_VALUE_UINT;
+  isegDeadbandOf( prec, pinfo );
+  pinfo->vvalid = false;
+  pinfo->parray = NULL;
+  isegHalDiskCache::instance().remember( options.at(1), isegItem );
 
   /// Get initial value from HAL
-  IsegItem item = iseg_getItem( pinfo->interface, pinfo->object );
+  if( !warm && !isegHalPrefetch::instance().take( options.at(1), pinfo->object, item ) )
+    item = iseg_getItem( pinfo->interface, pinfo->object );
   if( strcmp( item.quality, ISEG_ITEM_QUALITY_OK ) != 0 ) {
     fprintf( stderr, "\033[31;1m%s: Error while reading value '%s' from interface '%s': '%s' (Q: %s)\033[0m\n",
        prec->name, item.object, pinfo->interface, item.value, item.quality );
   }
   memcpy( pinfo->quality, item.quality,  QUALITY_SIZE ); //  init  rec quality info
 
-  epicsUInt32 seconds = 0;
-  epicsUInt32 microsecs = 0;
-  if( sscanf( item.timeStampLastChanged, "%u.%u", &seconds, &microsecs ) != 2 ) {
+  // array records are updated by their own reads of all channels only
+  pinfo->pcache = isegHalCache::instance().subscribe( pinfo->interface, item, pattern.empty() ? pinfo : NULL );
+  pinfo->time = pinfo->pcache->time; // decoded once per item by the cache
+  if( 0 == strcmp( item.quality, ISEG_ITEM_QUALITY_OK ) && 0 == pinfo->time.secPastEpoch ) {
     fprintf( stderr, "\033[31;1m%s: Error parsing timestamp for '%s': %s\033[0m\n", prec->name, pinfo->object, item.timeStampLastChanged );
   }
+  if( !pattern.empty() ) pinfo->parray = isegInitArray( pinfo, pattern, pconf->nelm );
+  isegStoreValue( pinfo, item.value );
 
-  memcpy( pinfo->rtime, item.timeStampLastChanged,  TIME_SIZE ); // needed by worker thread
-  pinfo->time.secPastEpoch = seconds - POSIX_TIME_AT_EPICS_EPOCH;
-  pinfo->time.nsec = microsecs * 100000;
-
-  status = pdset->conv_val_str( prec, item.value );
+  status = pdset->conv_val_str( prec, pinfo->value );
   if( ERROR == status ) {
     fprintf( stderr, "\033[31;1m%s: Error parsing value for '%s': %s\033[0m\n", prec->name, pinfo->object, item.value );
   }
 
   if( -2 == prec->tse ) prec->time = pinfo->time;
-  // update interface
-  std::string _interface = options.at(1) + "_MOD";
-  strncpy( pinfo->interface, _interface.c_str(), 20 );
-
-  /// I/O Intr handling
-  scanIoInit( &pinfo->ioscanpvt );
+  if( warm ) {
+    // flag the value as stale until it has been read from isegHAL
+    prec->stat = READ_ALARM;
+    prec->sevr = MINOR_ALARM;
+  }
+  // all requests for this item are served by the worker of its line/module
+  pinfo->shard = isegWorkerOf( pinfo->interface, pinfo->object );
+  if( strchr( pconf->access, 'W' ) ) isegCountWriter( pinfo );
+
+  /// I/O Intr handling, one scan list per channel or module
+  pinfo->pscan = isegScanGroupOf( pinfo->interface, pinfo->object, pinfo->shard );
+  pinfo->intr = false;
+  pinfo->cstatus = status;
   // All Record will use Async Processing
     regCallback( prec, pinfo );
 
@@ -576,6 +1851,29 @@ long devIsegHalGlobalSwitchInit( dbCommon *prec, const devIsegHal_rec_t *pconf )
   strncpy( pinfo->interface, options.at(1).c_str(), 20 );
   memset( pinfo->unit, 0, UNIT_SIZE );
   pinfo->pcallback = NULL;  // just to be sure
+  pinfo->shard = isegWorkerOf( pinfo->interface, "" );
+  isegCountWriter( pinfo );
+  pinfo->inflight = 0;
+  pinfo->wvalue[0] = 0;
+  pinfo->wseq = 0;
+  pinfo->wlock = epicsMutexMustCreate();
+  pinfo->coalesce = false;
+  pinfo->deadband = 0.;
+  pinfo->relative = false;
+  pinfo->pollClass = POLL_NORMAL;
+  pinfo->polled = false;
+  pinfo->pollGen = 0;
+  pinfo->evented = false;
+  pinfo->regIndex = -1;
+  pinfo->stale = false;
+  pinfo->vtype = ISEG_VALUE_STRING;
+  pinfo->vvalid = false;
+  pinfo->pcache = NULL;
+  pinfo->bit = -1;
+  pinfo->parray = NULL;
+  pinfo->pscan = NULL;
+  pinfo->intr = false;
+  pinfo->cstatus = OK;
 
     // All record will use Async processing
     regCallback(prec, pinfo);
@@ -596,13 +1894,15 @@ long devIsegHalGlobalSwitchInit( dbCommon *prec, const devIsegHal_rec_t *pconf )
 long devIsegHalGetIoIntInfo( int cmd, dbCommon *prec, IOSCANPVT *ppvt ) {
   devIsegHal_info_t *pinfo = (devIsegHal_info_t *)prec->dpvt;
 
-	if (pinfo) *ppvt = pinfo->ioscanpvt; // deal with crash when crates are not  on
+  if( !pinfo ) return ERROR; // deal with crash when crates are not on
+  *ppvt = pinfo->pscan->ioscanpvt;
 
   if ( 0 == cmd ) {
-
+    pinfo->intr = true;
     myIsegHalThread->registerInterrupt( prec, pinfo );
   } else {
     myIsegHalThread->cancelInterrupt( pinfo );
+    pinfo->intr = false;
   }
   return OK;
 }
@@ -611,24 +1911,34 @@ long devIsegHalGetIoIntInfo( int cmd, dbCommon *prec, IOSCANPVT *ppvt ) {
 //! @brief       Common read function of the records
 //! @param [in]  prec  Address of record calling this funciton
 //! @return      ERROR in case of an error, otherwise OK
+//!
+//! Records scanned on I/O Intr are processed by the scan of their channel or module
+//! and complete synchronously, with their update or, if only other
+//! records of the list have been updated, keeping VAL.
 //------------------------------------------------------------------------------
 long devIsegHalRead( dbCommon *prec ) {
 
 	devIsegHal_info_t *pinfo = (devIsegHal_info_t *)prec->dpvt;
   devIsegHal_dset_t *pdset = (devIsegHal_dset_t *)prec->dset;
   long status = OK;
+  bool update = !prec->pact && isegTakeUpdate( pinfo );
 
-  if( !prec->pact )
+  if( !prec->pact && !update && pinfo->intr ) {
+    // scanned for other records of the list, keep VAL and its alarm
+    if( ERROR == pinfo->cstatus ) recGblSetSevr( prec, READ_ALARM, INVALID_ALARM );
+    else if( pinfo->stale ) recGblSetSevr( prec, READ_ALARM, MINOR_ALARM );
+    return pinfo->cstatus;
+  }
+
+  if( !prec->pact && !update )
   {
     // record "normally" processed
-    pinfo->pflag = P_ASYNC;
-    devIsegHal_queue_t qmsg = { pinfo, GET_ITEM, NULL };
     /*std::cout << prec->name <<":== Starting async read ==: (" << __FUNCTION__ << ") in thread: "
                 << epicsThreadGetNameSelf()
                 << std::endl;*/
     /* Send it to the servicing task */
     prec->pact = (epicsUInt8)true; // dont forget to set
-    if (epicsMessageQueueTrySend(isegClientQueue, &qmsg, sizeof(devIsegHal_queue_t))){
+    if( ISEG_READ_FAILED == isegRequestRead( pinfo, ISEG_INFLIGHT_READ ) ){
 		fprintf( stderr, "\033[31;1m%s: isegHal Mgt Queue Overflowed '%s': %s\033[0m\n", prec->name, pinfo->object, pinfo->value );
 		recGblSetSevr( prec, READ_ALARM, INVALID_ALARM ); // Set record to READ_ALARM
 		return ERROR;
@@ -636,9 +1946,12 @@ long devIsegHalRead( dbCommon *prec ) {
   }
 	else
 	{
-    // record forced processed by CALLBACK: an epics callback will start processing from here
+    // record forced processed by CALLBACK: an epics callback will start processing from here,
+    // or scanned on I/O Intr with an update
 		/*std::cout << prec->name << " :== Completing async read ==:" << pinfo->value <<  " :(" << __FUNCTION__ << ") in thread id: "
                 << epicsThreadGetNameSelf() << std::endl;*/
+		pinfo->stale = false; // value has been read from isegHAL
+		isegClearInflight( pinfo, ISEG_INFLIGHT_CALLBACK );
 		if(pinfo->pflag == P_ASYNC) { // this flag must be set before calling back here
 			// Deal with read Operation data: this done after worker has called back
 			if( strcmp( pinfo->quality, ISEG_ITEM_QUALITY_OK ) != 0 ) {
@@ -647,25 +1960,14 @@ long devIsegHalRead( dbCommon *prec ) {
 				recGblSetSevr( prec, READ_ALARM, INVALID_ALARM ); // Set record to READ_ALARM
 				return ERROR;
 			}
-			epicsUInt32 seconds = 0;
-			epicsUInt32 microsecs = 0;
-			if( sscanf( pinfo->rtime, "%u.%u", &seconds, &microsecs ) != 2 ) {
-				fprintf( stderr, "\033[31;1m%s: Error parsing timestamp for '%s': %s\033[0m\n", prec->name, pinfo->object, pinfo->rtime );
+			// pinfo->time has been decoded by the worker when the item was fetched
+			if( 0 == pinfo->time.secPastEpoch ) {
+				fprintf( stderr, "\033[31;1m%s: Error parsing timestamp for '%s'\033[0m\n", prec->name, pinfo->object );
 				recGblSetSevr( prec, READ_ALARM, INVALID_ALARM ); // Set record to READ_ALARM
 				return ERROR;
 			}
-			pinfo->time.secPastEpoch = seconds - POSIX_TIME_AT_EPICS_EPOCH;
-			pinfo->time.nsec = microsecs * 100000;
 #ifdef CHECK_LAST_REFRESHED
-			epicsTimeStamp lastRefreshed;
-			if( sscanf( pinfo->rtime, "%u.%u", &lastRefreshed.secPastEpoch, &lastRefreshed.nsec ) != 2 ) {
-				fprintf( stderr, "\033[31;1m%s: Error parsing timestamp for '%s': %s\033[0m\n", prec->name, pinfo->object, pinfo->rtime );
-				recGblSetSevr( prec, READ_ALARM, INVALID_ALARM ); // Set record to READ_ALARM
-				return ERROR;
-			}
-			lastRefreshed.secPastEpoch -= POSIX_TIME_AT_EPICS_EPOCH;
-			lastRefreshed.nsec *= 100000;
-			if( epicsTime::getCurrent() - epicsTime( lastRefreshed ) >= 30.0 ) {
+			if( epicsTime::getCurrent() - epicsTime( pinfo->time ) >= 30.0 ) {
 				/// value is older then 30 seconds
 				recGblSetSevr( prec, TIMEOUT_ALARM, INVALID_ALARM );
 				return ERROR;
@@ -675,6 +1977,7 @@ long devIsegHalRead( dbCommon *prec ) {
 		// IO_INTR record with errors wont callback
 		status = pdset->conv_val_str( prec, pinfo->value );
 		prec->pact = (epicsUInt8)false;
+		pinfo->cstatus = status;
 		if( ERROR == status ) {
 			fprintf( stderr, "\033[31;1m%s: Error parsing value for '%s': %s\033[0m\n", prec->name, pinfo->object, pinfo->value );
 			recGblSetSevr( prec, READ_ALARM, INVALID_ALARM ); // Set record to READ_ALARM
@@ -690,6 +1993,35 @@ long devIsegHalRead( dbCommon *prec ) {
   return status;
 }
 
+//------------------------------------------------------------------------------
+//! @brief       Check if a record has to be processed by its callback
+//! @param [in]  prec  Address of the record, locked by the caller
+//! @return      false if the callback has nothing to complete
+//!
+//! Records waiting for a write are only processed once the write has been
+//! completed. Records which are not active are processed with the readback
+//! delivered by the worker. If puts to a coalesced record arrived while its
+//! write was pending (RPRO), the record is not completed, but processed
+//! again with the latest value. The superseded puts complete with the
+//! status of this last write.
+//------------------------------------------------------------------------------
+bool devIsegHalPrepare( dbCommon *prec ) {
+  devIsegHal_info_t *pinfo = (devIsegHal_info_t *)prec->dpvt;
+
+  int pending = epicsAtomicGetIntT( &pinfo->inflight );
+  if( pending & ISEG_INFLIGHT_WRITE ) return false; // record is called back when the write is done
+  if( !( pending & ISEG_INFLIGHT_CALLBACK ) ) return false; // completed by an earlier callback
+
+  if( !prec->pact ) {
+    prec->pact = (epicsUInt8)true; // readback
+  } else if( pinfo->coalesce && prec->rpro && P_ASYNC == pinfo->pflag ) {
+    isegClearInflight( pinfo, ISEG_INFLIGHT_CALLBACK );
+    prec->rpro = (epicsUInt8)false;
+    prec->pact = (epicsUInt8)false;
+  }
+  return true;
+}
+
 //------------------------------------------------------------------------------
 //! @brief       Common write function of the records
 //! @param [in]  prec   Address of record calling this function
@@ -702,6 +2034,8 @@ long devIsegHalWrite( dbCommon *prec ) {
   long status = 0;
 
   if( prec->pact ) {
+    pinfo->stale = false;
+    isegClearInflight( pinfo, ISEG_INFLIGHT_CALLBACK );
     if( pinfo->ioStatus != ISEG_OK) {  //write successful ?
       fprintf( stderr, "\033[31;1m%s Error while writing value '%s'\033[0m\n",
         pinfo->interface, pinfo->object);
@@ -729,14 +2063,12 @@ long devIsegHalWrite( dbCommon *prec ) {
     std::cout << prec->name <<" : " << _value << " :== Starting write async operation == : (" << __FUNCTION__ << ") in thread id: "
              << epicsThreadGetNameSelf() << std::endl;
 
-    devIsegHal_queue_t qmsg;
     pinfo->pflag = P_ASYNC; // Normal processing;
-    qmsg.pdata = pinfo;
-    qmsg.reqType = SET_ITEM;
-    strncpy( qmsg.value, _value, VALUE_SIZE );
+    prec->pact = (epicsUInt8)true; // until write has been completed
     //Send write request to the servicing task
-    if (epicsMessageQueueTrySend(isegClientQueue, &qmsg, sizeof(devIsegHal_queue_t))){
+    if( !isegRequestWrite( pinfo, SET_ITEM, _value ) ){
       fprintf( stderr, "\033[31;1m%s: isegHal Mgt Queue Overflowed '%s': %s\033[0m\n", prec->name, pinfo->object, _value );
+      prec->pact = (epicsUInt8)false;
       recGblSetSevr( prec, SOFT_ALARM, INVALID_ALARM ); // Set record to READ_ALARM
       return ERROR;
     }
@@ -755,6 +2087,7 @@ long devIsegHalGlobalSwitchWrite( dbCommon *prec ) {
   long status = 0;
 
   if(prec->pact){
+    isegClearInflight( pinfo, ISEG_INFLIGHT_CALLBACK );
     if( pinfo->ioStatus != ISEG_OK) {  //write successful ?
       fprintf( stderr, "\033[31;1m%s Error while writing value '%s'\033[0m\n",
         pinfo->interface, pinfo->object);
@@ -786,14 +2119,12 @@ long devIsegHalGlobalSwitchWrite( dbCommon *prec ) {
       return ERROR;
     }
 
-    devIsegHal_queue_t qmsg;
     pinfo->pflag = P_ASYNC; // Normal processing;
-    qmsg.pdata = pinfo;
-    qmsg.reqType = SET_ITEM;
-    strncpy( qmsg.value, _value, VALUE_SIZE );
+    prec->pact = (epicsUInt8)true; // until write has been completed
     //Send write request to the servicing task
-    if (epicsMessageQueueTrySend(isegClientQueue, &qmsg, sizeof(devIsegHal_queue_t))){
+    if( !isegRequestWrite( pinfo, SET_ITEM, _value ) ){
       fprintf( stderr, "\033[31;1m%s: isegHal Mgt Queue Overflowed '%s': %s\033[0m\n", prec->name, pinfo->object, _value );
+      prec->pact = (epicsUInt8)false;
       recGblSetSevr( prec, SOFT_ALARM, INVALID_ALARM ); // Set record to READ_ALARM
       return ERROR;
     }
@@ -808,10 +2139,22 @@ long devIsegHalGlobalSwitchWrite( dbCommon *prec ) {
 isegHalThread::isegHalThread()
   : thread( *this, "isegHAL", epicsThreadGetStackSize( epicsThreadStackSmall ), 50 ),
     _run( true ),
-    _pause(5.),
-    _debug(0)
+    _exit( 0 ),
+    _eventMode( 0 ),
+    _eventPause( 0.1 ),
+    _eventDue( 0. ),
+    _groupsVersion( 0 ),
+    _debug(0),
+    _recsVersion( 0 ),
+    _snapshotVersion( 0 )
 {
         std::cout <<"Createding isegHAL thread:  "<< _run<<"(" << __FUNCTION__ << ") was called by thread id: " << epicsThreadGetNameSelf()<< std::endl;
+  _pause[ POLL_FAST ] = 0.5;
+  _pause[ POLL_NORMAL ] = 5.;
+  _pause[ POLL_SLOW ] = 60.;
+  _pause[ POLL_ONCE ] = 0.;
+  memset( _stats, 0, sizeof( _stats ) );
+  memset( _registered, 0, sizeof( _registered ) );
   _recs.clear();
 }
 
@@ -820,96 +2163,353 @@ isegHalThread::isegHalThread()
 //------------------------------------------------------------------------------
 isegHalThread::~isegHalThread() {
         std::cout << "(" << __FUNCTION__ << ") Cleaning up: " << epicsThreadGetNameSelf() << std::endl;
-epicsThreadSleep(4);
   _recs.clear();
+  for( size_t i = 0; i < _groups.size(); ++i ) delete _groups[i];
+  _groups.clear();
+  for( size_t i = 0; i < _retired.size(); ++i ) delete _retired[i];
+  _retired.clear();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get the poll interval of a record
+//! @param [in]  pinfo  Address of the record's private data structure
+//!
+//! In event mode the items of watched modules are read on events, the
+//! regular poll of normal class records is only a fallback and uses the
+//! interval of the slow class.
+//------------------------------------------------------------------------------
+double isegHalThread::interval( devIsegHal_info_t const* pinfo ) const {
+  if( _eventMode && pinfo->evented && POLL_NORMAL == pinfo->pollClass ) return _pause[ POLL_SLOW ];
+  return _pause[ pinfo->pollClass ];
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Collect the modules to be watched in event mode
+//!
+//! Each module with registered items on a CAN line is watched. Of each
+//! item one registered record is read on events, the others are served
+//! from the cache.
+//! The groups are rebuilt whenever the registry has changed, as I/O Intr
+//! records are registered by scanInit after the thread has been started.
+//! Groups that may still be queued at a worker are kept until their check
+//! has finished.
+//------------------------------------------------------------------------------
+void isegHalThread::buildEventGroups() {
+  std::vector< devIsegHal_info_t* > const& recs = snapshot();
+  if( _groupsVersion == _snapshotVersion ) return;
+  _groupsVersion = _snapshotVersion;
+  size_t watched = _groups.size();
+
+  std::vector< isegEventGroup* > retired;
+  for( size_t i = 0; i < _retired.size(); ++i ) {
+    if( epicsAtomicGetIntT( &_retired[i]->inflight ) ) retired.push_back( _retired[i] );
+    else delete _retired[i];
+  }
+  for( size_t i = 0; i < _groups.size(); ++i ) {
+    if( epicsAtomicGetIntT( &_groups[i]->inflight ) ) retired.push_back( _groups[i] );
+    else delete _groups[i];
+  }
+  _retired.swap( retired );
+  _groups.clear();
+
+  std::map< std::string, isegEventGroup* > groups;
+  std::map< std::string, size_t > words;
+  std::set< isegCacheEntry* > seen;
+  std::vector< devIsegHal_info_t* >::const_iterator it = recs.begin();
+  for( ; it != recs.end(); ++it ) ( *it )->evented = false;
+  for( it = recs.begin(); it != recs.end(); ++it ) {
+    devIsegHal_info_t* member = *it;
+    // array records are read on events of each of their channels
+    std::vector< isegCacheEntry* > entries;
+    if( member->parray ) entries = member->parray->entries;
+    else if( member->pcache ) entries.push_back( member->pcache );
+
+    std::vector< isegCacheEntry* >::iterator entry = entries.begin();
+    for( ; entry != entries.end(); ++entry ) {
+      if( !member->parray && !seen.insert( *entry ).second ) continue;
+
+      // object is <line>.<module>[.<channel>].<item>, other items are not watched
+      std::string object( (*entry)->object );
+      size_t item = object.rfind( '.' );
+      size_t dot = object.find( '.' );
+      if( std::string::npos == item || dot == item ) continue;
+      if( object.compare( item + 1, std::string::npos, "EventStatus" ) == 0 ) continue;
+      std::string prefix = object.substr( 0, item );
+      std::string module = prefix.substr( 0, prefix.find( '.', dot + 1 ) );
+
+      std::string key = std::string( member->interface ) + ":" + module;
+      isegEventGroup* group = groups[ key ];
+      if( !group ) {
+        group = new isegEventGroup;
+        group->clear = module + ".Control:6"; // doClear of the module, clears channel events too
+        group->shard = member->shard;
+        group->inflight = 0;
+        group->autoClear = false;
+        groups[ key ] = group;
+        _groups.push_back( group );
+      }
+      key = std::string( member->interface ) + ":" + prefix;
+      std::map< std::string, size_t >::iterator word = words.find( key );
+      if( word == words.end() ) {
+        isegEventWord w;
+        w.status = prefix + ".EventStatus";
+        w.pstatus = isegHalCache::instance().find( member->interface, w.status );
+        w.last = 0;
+        w.events = 0;
+        group->words.push_back( w );
+        word = words.insert( std::make_pair( key, group->words.size() - 1 ) ).first;
+      }
+      group->words[ word->second ].members.push_back( member );
+      member->evented = true;
+      std::vector< devIsegHal_info_t* >::iterator sub = (*entry)->subscribers.begin();
+      for( ; sub != (*entry)->subscribers.end(); ++sub ) ( *sub )->evented = true;
+    }
+  }
+  if( watched != _groups.size() )
+    printf( "isegHalThread: Watching events of %lu module(s)\n", (unsigned long)_groups.size() );
 }
 
 //------------------------------------------------------------------------------
 //! @brief       Run operation of thread
 //!
-//! Go through the list of registered records and check the cached value
-//! from isegHAL.
-//! If the cached value differs from the current value in the record,
-//! the record will be updated.
-//! After having checked all records, the thread sleeps for 5 seconds and
-//! repeats the check.
+//! Each registered record has its own deadline in the poll schedule
+//! (a min-heap ordered by due time). The thread sleeps until the earliest
+//! deadline, sends the read requests of all due records to the workers
+//! and schedules their next poll one interval of their poll class after
+//! the previous deadline, so the refresh period does not drift with the
+//! time needed for dispatching and reading.
+//! New records get a phase within their interval, so the polls of one
+//! class are spread evenly over the interval instead of being sent at
+//! once. If the poll lane of a worker is half full, due polls for this
+//! worker are deferred by ISEG_POLL_BACKOFF, which paces the dispatch by
+//! the throughput of the workers and keeps the lanes from overflowing.
+//! The deviation of the actual from the nominal period (jitter) is
+//! collected for each poll class and reported with debug level >= 1.
 //------------------------------------------------------------------------------
 void isegHalThread::run() {
 std::cout <<"isegHal Thread:  "<< _run<<"(" << __FUNCTION__ << ") was called by thread id: " << epicsThreadGetNameSelf()<< std::endl;
+std::vector< isegPollEntry_t > due;
+double nextReport = isegMonotonicNow() + ISEG_POLL_REPORT;
+unsigned long joined = 0;
+unsigned long shed = 0;
 while( true ) {
-  std::list<devIsegHal_info_t*>::iterator it = _recs.begin();
-  if( _pause > 0. ) this->thread.sleep( _pause );
+  double now = isegMonotonicNow();
+  double wait = ISEG_POLL_REPORT;
+
+  _lock.lock();
+  if( !_schedule.empty() ) wait = _schedule.front().due - now;
+  if( _eventMode && _eventDue - now < wait ) wait = _eventDue - now;
+  _lock.unlock();
+  if( wait > 0. ) {
+    if( wait > nextReport - now ) wait = nextReport - now;
+    _wakeup.wait( wait );
+  }
+
+  if( epicsAtomicGetIntT( &_exit ) ) break;
+  if( !_run ) {
+    this->thread.sleep( 0.01 );
+    continue;
+  }
 
-  if( !_run ) continue;
+  // take all due records from the schedule and reschedule them
+  now = isegMonotonicNow();
+  due.clear();
+  _lock.lock();
+  for( size_t n = _schedule.size(); n > 0 && !_schedule.empty() && _schedule.front().due <= now; --n ) {
+    std::pop_heap( _schedule.begin(), _schedule.end(), isegPollLater() );
+    isegPollEntry_t entry = _schedule.back();
+    _schedule.pop_back();
+    if( !entry.pinfo->polled || entry.gen != entry.pinfo->pollGen ) continue; // record has been cancelled
+
+    if( isegPollCongested( entry.pinfo ) ) {
+      // worker busy: try again later, without losing the period
+      _stats[ entry.pinfo->pollClass ].deferred++;
+      entry.due = now + ISEG_POLL_BACKOFF;
+      _schedule.push_back( entry );
+      std::push_heap( _schedule.begin(), _schedule.end(), isegPollLater() );
+      continue;
+    }
 
-  // some "benchmarking"
-  struct timespec       start;
-#ifdef _POSIX_CPUTIME
-        clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &start );
-#else
-        clock_gettime( CLOCK_MONOTONIX, &start );
-#endif
-  //std::cout << _recs.front()->object << _recs.back()->object << " : "<<_run<<_pause<<_debug<< "(" << __FUNCTION__ << ") was called by thread id: " << epicsThreadGetNameSelf()<< std::endl;
-  for( ; it != _recs.end(); ++it ) {
+    double interval = this->interval( entry.pinfo );
+    if( entry.last > 0. ) {
+      isegPollStats_t& stats = _stats[ entry.pinfo->pollClass ];
+      double jitter = fabs( now - entry.last - interval );
+      stats.count++;
+      stats.sum += jitter;
+      if( jitter > stats.max ) stats.max = jitter;
+    }
+    due.push_back( entry );
+    if( POLL_ONCE == entry.pinfo->pollClass ) {
+      // read once to verify a value of a warm restart
+      entry.pinfo->polled = false;
+      continue;
+    }
+
+    entry.last = now;
+    entry.due = entry.phase + interval;
+    entry.phase = entry.due;
+    if( entry.due < now ) {
+      // don't catch up missed cycles
+      if( interval > 0. ) _stats[ entry.pinfo->pollClass ].missed++;
+      entry.due = entry.phase = now + interval;
+    }
+    _schedule.push_back( entry );
+    std::push_heap( _schedule.begin(), _schedule.end(), isegPollLater() );
+  }
+  _lock.unlock();
 
+  for( std::vector< isegPollEntry_t >::iterator it = due.begin(); it != due.end(); ++it ) {
     if( 3 <= _debug )
-    printf( "isegHalThread::run: Reading item '%s'\n", (*it)->object );
-
-    if ((*it)) {
-                        (*it)->pflag = P_IO_INTR; // to be sure.
-      devIsegHal_queue_t qmsg = {(*it), GET_ITEM, NULL};
-      // Send it to the servicing task
-      if (epicsMessageQueueTrySend(isegClientQueue, &qmsg,
-        sizeof(devIsegHal_queue_t))){
-        fprintf( stderr, "\033[31;1m%s: Warning: iseg Client Mgt queue overflow.\033[0m\n",
-        (*it)->object);
+    printf( "isegHalThread::run: Reading item '%s'\n", it->pinfo->object );
+
+    // Send it to the servicing task, unless a read is already pending
+    int result = isegRequestRead( it->pinfo, ISEG_INFLIGHT_POLL );
+    if( ISEG_READ_JOINED == result ) ++joined;
+    // poll lane full: shed this poll, the item is read again next cycle
+    if( ISEG_READ_FAILED == result ) ++shed;
+  }
+
+  // check the EventStatus words of the watched modules
+  if( _eventMode && _eventDue <= now ) {
+    _eventDue = now + _eventPause;
+    buildEventGroups();
+    for( std::vector< isegEventGroup* >::iterator it = _groups.begin(); it != _groups.end(); ++it ) {
+      isegEventGroup* pgroup = *it;
+      if( epicsAtomicCmpAndSwapIntT( &pgroup->inflight, 0, 1 ) != 0 ) continue; // previous check pending
+      pgroup->autoClear = ( 2 == _eventMode );
+      if( isegWorkers.empty() || !isegWorkers[ pgroup->shard % isegWorkers.size() ]->request( pgroup ) ) {
+        epicsAtomicSetIntT( &pgroup->inflight, 0 );
+        ++shed;
       }
     }
   }
-  // some "benchmarking"
+
+  if( now < nextReport ) continue;
+  nextReport = now + ISEG_POLL_REPORT;
   if( 1 <= _debug ) {
-      struct timespec   stop;
-#ifdef _POSIX_CPUTIME
-          clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &stop );
-#else
-          clock_gettime( CLOCK_MONOTONIX, &stop );
-#endif
-    printf( "isegHalThread::run: needed %lf seconds for %lu records\n",
-            timespec_diff( &stop, &start ), (unsigned long)_recs.size() );
-                }
+    static const char* names[ NUM_POLL_CLASSES ] = { "fast", "normal", "slow", "once" };
+    _lock.lock();
+    for( unsigned c = 0; c < POLL_ONCE; ++c ) {
+      isegPollStats_t& stats = _stats[c];
+      if( stats.count )
+        printf( "isegHalThread::run: %-6s %8.3lf s: %lu polls, jitter mean %.3lf ms max %.3lf ms, %lu missed, %lu deferred\n",
+                names[c], _pause[c], stats.count, stats.sum / stats.count * 1.e3, stats.max * 1.e3, stats.missed, stats.deferred );
+      memset( &stats, 0, sizeof( stats ) );
+    }
+    printf( "isegHalThread::run: %lu records scheduled, %lu items cached (%lu joined pending reads)\n",
+            (unsigned long)_recs.size(), (unsigned long)isegHalCache::instance().size(), joined );
+    if( _eventMode ) {
+      unsigned long events = 0;
+      for( size_t i = 0; i < _groups.size(); ++i )
+        for( size_t j = 0; j < _groups[i]->words.size(); ++j ) events += _groups[i]->words[j].events;
+      printf( "isegHalThread::run: %lu module(s) watched, %lu events\n", (unsigned long)_groups.size(), events );
+    }
+    _lock.unlock();
+  }
+  if( shed ) {
+    fprintf( stderr, "\033[31;1mWarning: iseg Client Mgt poll lane overflow, %lu polls shed.\033[0m\n", shed );
   }
+  isegDispatchReport( ISEG_POLL_REPORT, 1 <= _debug );
+  joined = 0;
+  shed = 0;
+  }
+  _done.signal();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Stop the thread
+//! @param [in]  timeout  Max. time to wait for the thread [s]
+//! @return      false if the thread did not stop in time
+//------------------------------------------------------------------------------
+bool isegHalThread::stop( double timeout ) {
+  epicsAtomicSetIntT( &_exit, 1 );
+  _wakeup.signal();
+  return _done.wait( timeout );
 }
 
 //------------------------------------------------------------------------------
 //! @brief       Add a record to the list
 //! @param [in]  prec  Address of the record to be added
 //!
-//! Registers a new record to be checked by the thread
+//! Registers a new record to be checked by the thread. Each record keeps
+//! its position in the registry, so adding it again is a no-op.
 //------------------------------------------------------------------------------
 void isegHalThread::registerInterrupt( dbCommon* prec,  devIsegHal_info_t *pinfo ) {
 
+  if( POLL_ONCE == pinfo->pollClass && !pinfo->stale ) {
+    if( 1 <= _debug )
+      printf( "isegHalThread: Record '%s' is read only once\n", prec->name );
+    return;
+  }
   if( 1 <= _debug )
     printf( "isegHalThread: Register new record '%s'\n", prec->name );
-  _recs.push_back( pinfo );
-  // to be sure that each record is only added once
-    _recs.sort();
-    _recs.unique();
+
+  epicsGuard< epicsMutex > guard( _lock );
+  if( pinfo->regIndex < 0 ) {
+    pinfo->regIndex = (int)_recs.size();
+    _recs.push_back( pinfo );
+    _recsVersion++;
+  }
+
+  if( pinfo->polled ) return; // still in schedule
+  pinfo->polled = true;
+  // spread the records of each class over the interval (golden ratio
+  // sequence, even without knowing the final number of records)
+  // records of the same item share the phase, so the item is read only
+  // once and the others are served from the cache
+  double phase = pinfo->pcache ? pinfo->pcache->phase : -1.;
+  if( phase < 0. ) phase = fmod( _registered[ pinfo->pollClass ]++ * 0.6180339887, 1. );
+  if( pinfo->pcache ) pinfo->pcache->phase = phase;
+  isegPollEntry_t entry;
+  // values of a warm restart are verified soon, the next polls keep the phase
+  double first = _pause[ pinfo->pollClass ];
+  if( pinfo->stale && ( first > ISEG_POLL_WARMUP || POLL_ONCE == pinfo->pollClass ) ) first = ISEG_POLL_WARMUP;
+  entry.due = isegMonotonicNow() + phase * first;
+  entry.phase = entry.due;
+  entry.last = 0.;
+  entry.pinfo = pinfo;
+  entry.gen = pinfo->pollGen;
+  _schedule.push_back( entry );
+  std::push_heap( _schedule.begin(), _schedule.end(), isegPollLater() );
+  _wakeup.signal();
 }
 
 //------------------------------------------------------------------------------
 //! @brief       Remove a record to the list
 //! @param [in]  pinfo  Address of the record's private data structure
 //!
-//! Removes a record from the list which is checked by the thread for updates
+//! Removes a record from the list which is checked by the thread for updates.
+//! The last record of the registry takes its position. Its entry in the
+//! schedule is dropped when it is due the next time.
 //------------------------------------------------------------------------------
-void isegHalThread::cancelInterrupt( const devIsegHal_info_t* pinfo ) {
-  std::list<devIsegHal_info_t*>::iterator it = _recs.begin();
-  for( ; it != _recs.end(); ++it ) {
-    if( pinfo == (*it) ) {
-      _recs.erase( it );
-      break;
-    }
+void isegHalThread::cancelInterrupt( devIsegHal_info_t* pinfo ) {
+  epicsGuard< epicsMutex > guard( _lock );
+  pinfo->polled = false;
+  pinfo->pollGen++;
+  if( pinfo->regIndex < 0 ) return;
+  devIsegHal_info_t* last = _recs.back();
+  _recs[ pinfo->regIndex ] = last;
+  last->regIndex = pinfo->regIndex;
+  _recs.pop_back();
+  pinfo->regIndex = -1;
+  _recsVersion++;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get the registered records
+//! @return      Copy of the registry, valid until the next call
+//!
+//! Must only be called by the thread itself. The registry is only copied
+//! if it has been changed since the last call, so the thread can iterate
+//! the records without holding the lock.
+//------------------------------------------------------------------------------
+std::vector< devIsegHal_info_t* > const& isegHalThread::snapshot() {
+  epicsGuard< epicsMutex > guard( _lock );
+  if( _snapshotVersion != _recsVersion ) {
+    _snapshot = _recs;
+    _snapshotVersion = _recsVersion;
   }
+  return _snapshot;
 }
 
 // Configuration routines.  Called from the iocsh function below
@@ -932,7 +2532,9 @@ extern "C" {
     std::cout << "using HAL version [" << iseg_getVersionString() << "]" << std::endl;
     if( !isegHalConnectionHandler::instance().connect( args[0].sval, args[1].sval ) ){
       fprintf( stderr, "\033[31;1mCannot connect to isegHAL interface %s(%s)\033[0m\n", args[0].sval, args[1].sval );
+      return;
     }
+    isegHalConnectionHandler::instance().registerInterface( args[0].sval, args[1].sval );
   }
 
   // iocsh callable function to set options for polling thread
@@ -951,19 +2553,63 @@ extern "C" {
   //!
   //! Possible KEYs are:
   //! Intervall  -  set the wait time after going through the list of records with the polling thread
+  //! FastIntervall, SlowIntervall
+  //!            -  set the poll interval of records with info tag isegPoll "fast" or "slow"
+  //! EventMode  -  1: read items on events of their module (EventStatus), 2: and clear the events, 0: poll only
+  //! EventIntervall
+  //!            -  set the interval of the EventStatus checks in event mode
   //! LogLevel   -  Change loglevel of isegHalServer
   //! debug      -  Enable debug output of polling thread
+  //! Workers    -  Number of worker threads of each interface serving the isegHAL requests (before iocInit)
+  //! WriteLaneDepth, ReadLaneDepth, PollLaneDepth
+  //!            -  Max. number of queued writes, reads and polls per worker (before iocInit)
+  //! CacheFile  -  File for properties and values of the items, used for warm restarts (before iocInit)
+  //! InitSessions
+  //!            -  Number of sessions per interface reading the items of all records in parallel before record init (before iocInit)
+  //! Dispatchers
+  //!            -  Number of threads processing the completed records, 0 for EPICS callbacks (before iocInit)
+  //! DispatcherPriority
+  //!            -  EPICS priority (0-99) of the dispatcher threads (before iocInit)
   //----------------------------------------------------------------------------
   static void setOptCallFunc( const iocshArgBuf *args ) {
     // Set new intervall for polling thread
-    if( strcmp( args[1].sval, "Intervall" ) == 0 ) {
+    int pollClass = -1;
+    if( strcmp( args[1].sval, "Intervall" ) == 0 )     pollClass = POLL_NORMAL;
+    if( strcmp( args[1].sval, "FastIntervall" ) == 0 ) pollClass = POLL_FAST;
+    if( strcmp( args[1].sval, "SlowIntervall" ) == 0 ) pollClass = POLL_SLOW;
+    if( pollClass >= 0 ) {
       double newIntervall = 0.;
       int n = sscanf( args[2].sval, "%lf", &newIntervall );
-      if( 1 != n ) {
+      if( 1 != n || newIntervall < 0. ) {
+        fprintf( stderr, "\033[31;1mInvalid value for key '%s': %s\033[0m\n", args[1].sval, args[2].sval );
+        return;
+      }
+      // kept until the polling thread is created during iocInit
+      isegPollIntervall[ pollClass ] = newIntervall;
+      if( myIsegHalThread ) myIsegHalThread->changeIntervall( newIntervall, (devIsegHal_poll_t)pollClass );
+    }
+
+    // Enable reading items on events
+    if( strcmp( args[1].sval, "EventMode" ) == 0 ) {
+      unsigned mode = 0;
+      int n = sscanf( args[2].sval, "%u", &mode );
+      if( 1 != n || 2 < mode ) {
+        fprintf( stderr, "\033[31;1mInvalid value for key '%s': %s\033[0m\n", args[1].sval, args[2].sval );
+        return;
+      }
+      isegEventMode = mode;
+      if( myIsegHalThread ) myIsegHalThread->setEventMode( isegEventMode );
+    }
+
+    if( strcmp( args[1].sval, "EventIntervall" ) == 0 ) {
+      double newIntervall = 0.;
+      int n = sscanf( args[2].sval, "%lf", &newIntervall );
+      if( 1 != n || newIntervall <= 0. ) {
         fprintf( stderr, "\033[31;1mInvalid value for key '%s': %s\033[0m\n", args[1].sval, args[2].sval );
         return;
       }
-      myIsegHalThread->changeIntervall( newIntervall );
+      isegEventIntervall = newIntervall;
+      if( myIsegHalThread ) myIsegHalThread->changeEventIntervall( newIntervall );
     }
 
     // change log level from isegHAL server
@@ -982,7 +2628,79 @@ extern "C" {
         fprintf( stderr, "\033[31;1mInvalid value for key '%s': %s\033[0m\n", args[1].sval, args[2].sval );
         return;
       }
-      myIsegHalThread->setDbgLvl( newDbgLvl );
+      isegDebug = newDbgLvl;
+      if( myIsegHalThread ) myIsegHalThread->setDbgLvl( newDbgLvl );
+    }
+
+    // Set number of worker threads, only possible before iocInit
+    if( strcmp( args[1].sval, "Workers" ) == 0 ) {
+      unsigned newWorkers = 0;
+      int n = sscanf( args[2].sval, "%u", &newWorkers );
+      if( 1 != n || 0 == newWorkers ) {
+        fprintf( stderr, "\033[31;1mInvalid value for key '%s': %s\033[0m\n", args[1].sval, args[2].sval );
+        return;
+      }
+      if( !isegWorkers.empty() ) {
+        fprintf( stderr, "\033[31;1mWorker threads already running, '%s' has to be set before iocInit\033[0m\n", args[1].sval );
+        return;
+      }
+      isegNumWorkers = newWorkers;
+    }
+
+    // Set depth of the priority lanes of each worker, only possible before iocInit
+    int lane = -1;
+    if( strcmp( args[1].sval, "WriteLaneDepth" ) == 0 ) lane = LANE_WRITE;
+    if( strcmp( args[1].sval, "ReadLaneDepth" ) == 0 )  lane = LANE_READ;
+    if( strcmp( args[1].sval, "PollLaneDepth" ) == 0 )  lane = LANE_POLL;
+    if( lane >= 0 ) {
+      unsigned newDepth = 0;
+      int n = sscanf( args[2].sval, "%u", &newDepth );
+      if( 1 != n || 0 == newDepth ) {
+        fprintf( stderr, "\033[31;1mInvalid value for key '%s': %s\033[0m\n", args[1].sval, args[2].sval );
+        return;
+      }
+      if( !isegWorkers.empty() ) {
+        fprintf( stderr, "\033[31;1mWorker threads already running, '%s' has to be set before iocInit\033[0m\n", args[1].sval );
+        return;
+      }
+      isegLaneDepth[ lane ] = newDepth;
+    }
+
+    // Set file of the on-disk cache, only useful before iocInit
+    if( strcmp( args[1].sval, "CacheFile" ) == 0 ) {
+      if( !args[2].sval || '\0' == args[2].sval[0] ) {
+        fprintf( stderr, "\033[31;1mInvalid value for key '%s'\033[0m\n", args[1].sval );
+        return;
+      }
+      isegHalDiskCache::instance().setFile( args[2].sval );
+    }
+
+    // Set number of sessions for the parallel read before record init
+    if( strcmp( args[1].sval, "InitSessions" ) == 0 ) {
+      unsigned sessions = 0;
+      int n = sscanf( args[2].sval, "%u", &sessions );
+      if( 1 != n ) {
+        fprintf( stderr, "\033[31;1mInvalid value for key '%s': %s\033[0m\n", args[1].sval, args[2].sval );
+        return;
+      }
+      isegHalPrefetch::instance().setSessions( sessions );
+    }
+
+    // Set number and priority of the dispatcher threads, only possible before iocInit
+    bool dispatchers = ( strcmp( args[1].sval, "Dispatchers" ) == 0 );
+    if( dispatchers || strcmp( args[1].sval, "DispatcherPriority" ) == 0 ) {
+      unsigned newValue = 0;
+      int n = sscanf( args[2].sval, "%u", &newValue );
+      if( 1 != n || ( !dispatchers && epicsThreadPriorityMax < newValue ) ) {
+        fprintf( stderr, "\033[31;1mInvalid value for key '%s': %s\033[0m\n", args[1].sval, args[2].sval );
+        return;
+      }
+      if( !isegDispatchers.empty() || !isegWorkers.empty() ) {
+        fprintf( stderr, "\033[31;1mDispatcher threads already running, '%s' has to be set before iocInit\033[0m\n", args[1].sval );
+        return;
+      }
+      if( dispatchers ) isegNumDispatchers = newValue;
+      else isegDispatchPriority = newValue;
     }
 
   }
@@ -39,6 +39,7 @@
 #include <dbCommon.h>
 #include <dbScan.h>
 #include <devSup.h>
+#include <epicsMutex.h>
 #include <epicsTime.h>
 #include <shareLib.h>
 
@@ -75,9 +76,10 @@ typedef struct {
  */
 typedef struct {
   const struct link *ioLink;
-  const char   access[ACCESS_SIZE];
-  const char   type[DATA_TYPE_SIZE];
+  const char   *access;
+  const char   *type;
   const bool   registerIOInterrupt;//Modified
+  const epicsUInt32 nelm;           /**< Max. number of elements of array records, 0 for scalar records */
 } devIsegHal_rec_t;
 
 /**
@@ -90,6 +92,28 @@ typedef enum {
 	P_IO_INTR,
 }	devIsegHal_pflags_t;
 
+/**
+* @brief Type of the parsed value
+*
+* Used to select the typed value slot of a record
+*/
+typedef enum {
+	ISEG_VALUE_STRING = 0,  /**< value is only kept as cstring */
+	ISEG_VALUE_DOUBLE,      /**< R4/R8 items */
+	ISEG_VALUE_UINT,        /**< UI1/UI4/BOOL items and bits */
+}	devIsegHal_vtype_t;
+
+/* In-flight state of an item (devIsegHal_info_t::inflight) */
+#define ISEG_INFLIGHT_POLL     0x1  /**< read requested by polling thread is queued */
+#define ISEG_INFLIGHT_READ     0x2  /**< read requested by record processing is queued */
+#define ISEG_INFLIGHT_CALLBACK 0x4  /**< record is processed with the result of a read */
+#define ISEG_INFLIGHT_WRITE    0x8  /**< write request is queued */
+#define ISEG_INFLIGHT_UPDATE   0x10 /**< update is ready for the next I/O Intr scan of the record */
+
+struct isegCacheEntry;
+struct isegArray;
+struct isegScanGroup;
+
 /**
  * @brief Private Device Data
  *
@@ -100,13 +124,38 @@ typedef struct {
   char interface[20];                       /**< Interface name for isegHAL */
   char unit[UNIT_SIZE];                     /**< Engeneering unit of this item */
   CALLBACK *pcallback;                      /**< Address of EPICS callback structure */
-  IOSCANPVT ioscanpvt;                      /**< EPICS Structure needed for I/O Intrupt handling*/
+  struct dbCommon *precord;                 /**< Address of the record */
+  struct isegScanGroup *pscan;              /**< I/O Intr scan list shared by the records of the channel or module */
+  bool intr;                                /**< Record is scanned on I/O Intr, updates are delivered by pscan */
+  long cstatus;                             /**< Status of the last conversion, returned by scans without update */
   char value[VALUE_SIZE];                   /**< Value cstring from isegHAL */
+  devIsegHal_vtype_t vtype;                 /**< Type of the value slot */
+  bool vvalid;                              /**< Value slot holds the parsed value cstring */
+  union {
+    epicsFloat64 f64;
+    epicsUInt32 u32;
+  } num;                                    /**< Value slot, parsed once by the worker */
   char quality[QUALITY_SIZE];
 	epicsTimeStamp time;                      /**< Timestamp of last change from isegHAL */
-	char rtime[TIME_SIZE];										/**< raw time from isegHAL item*/
 	devIsegHal_pflags_t pflag;								/**< Processing request flag */
 	IsegResult ioStatus;											/**< store iostatus from worker thread */
+	unsigned shard;                           /**< Index of worker thread serving this item */
+	int inflight;                             /**< Pending requests, ISEG_INFLIGHT_* */
+	char wvalue[VALUE_SIZE];                  /**< Write slot: value cstring of pending write */
+	epicsUInt32 wseq;                         /**< Sequence number of the value in the write slot */
+	epicsMutexId wlock;                       /**< Protects the write slot */
+	bool coalesce;                            /**< Puts replace the value of a pending write */
+	epicsFloat64 deadband;                    /**< Min. change of the value to update the record, 0 for any change */
+	bool relative;                            /**< deadband is a fraction of the last value */
+	unsigned pollClass;                       /**< Poll rate class, devIsegHal_poll_t */
+	bool polled;                              /**< Record is in the poll schedule */
+	unsigned pollGen;                         /**< Invalidates poll schedule entries on cancel */
+	bool stale;                               /**< Value from on-disk cache, not yet read from isegHAL */
+	int regIndex;                             /**< Position in the registry of the polling thread, -1 if not registered */
+	struct isegCacheEntry *pcache;            /**< Shadow copy of the item */
+	int bit;                                  /**< Bit of the item ("@<isegItem>:<bit>"), -1 for whole item */
+	bool evented;                             /**< Item is read on events of its module/channel */
+	struct isegArray *parray;                 /**< Item of all channels of a module (array records), NULL otherwise */
 } devIsegHal_info_t;
 
 #ifdef __cplusplus
@@ -122,6 +171,11 @@ epicsShareExtern long devIsegHalGlobalSwitchInit( dbCommon *prec, const devIsegH
 epicsShareExtern long devIsegHalGlobalSwitchWrite( dbCommon *prec );
 
 epicsShareExtern void devIsegHalCallback( CALLBACK *pcallback );
+epicsShareExtern void devIsegHalProcess( dbCommon *prec );
+epicsShareExtern bool devIsegHalPrepare( dbCommon *prec );
+
+epicsShareExtern int devIsegHalParseDouble( const char *str, epicsFloat64 *pval );
+epicsShareExtern int devIsegHalParseUInt32( const char *str, epicsUInt32 *pval );
 
 #ifdef __cplusplus
 } //extern "C"
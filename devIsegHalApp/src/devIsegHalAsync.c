@@ -59,15 +59,25 @@
  *----------------------------------------------------------------------------*/
 void devIsegHalCallback( CALLBACK *pcallback ) {
   dbCommon *prec;
-  rset     *prset;
 
   callbackGetUser( prec, pcallback );
+  devIsegHalProcess( prec );
+}
+
+/**-----------------------------------------------------------------------------
+ * @brief   Process a record with the result of its request
+ * @param   [in]  prec   Address of the record
+ *
+ * Called by the EPICS callback and by the dispatcher threads of devIsegHal.
+ * PACT is set by devIsegHalPrepare with the record locked.
+ *----------------------------------------------------------------------------*/
+void devIsegHalProcess( dbCommon *prec ) {
+  rset     *prset;
 
-  prec->pact = (epicsUInt8)true;
   prset = (rset*)(prec->rset);
 
   dbScanLock( prec );
-  (*prset->process)( prec );
+  if( devIsegHalPrepare( prec ) ) (*prset->process)( prec );
 //  dbProcess( prec );
   dbScanUnlock( prec );
 }
@@ -0,0 +1,304 @@
+//******************************************************************************
+// Copyright (C) 2015 Florian Feldbauer <f.feldbauer@him.uni-mainz.de>
+//                    - Helmholtz-Institut Mainz
+//                    iseg Spezialelektronik GmbH
+//
+// This file is part of deviseg
+//
+// deviseg is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// deviseg is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// version 2.0.0; May 25, 2015
+//
+//******************************************************************************
+
+//! @file devIsegHalCache.cpp
+//! @brief Shadow copies of the isegHAL items
+
+//_____ I N C L U D E S ________________________________________________________
+
+// ANSI C/C++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// EPICS includes
+#include <epicsGuard.h>
+
+// local includes
+#include "devIsegHalClasses.hpp"
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+//_____ G L O B A L S __________________________________________________________
+
+//_____ L O C A L S ____________________________________________________________
+
+//_____ F U N C T I O N S ______________________________________________________
+
+//------------------------------------------------------------------------------
+//! @brief       C'tor of isegCacheEntry
+//------------------------------------------------------------------------------
+isegCacheEntry::isegCacheEntry()
+  : refreshed( 0. ),
+    changes( 0 ),
+    phase( -1. )
+{
+  memset( object, 0, FULLY_QUALIFIED_OBJECT_SIZE );
+  memset( value, 0, VALUE_SIZE );
+  memset( quality, 0, QUALITY_SIZE );
+  memset( rtime, 0, TIME_SIZE );
+  time.secPastEpoch = 0;
+  time.nsec = 0;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get reference to the cache
+//------------------------------------------------------------------------------
+isegHalCache& isegHalCache::instance() {
+  static isegHalCache myInstance;
+  return myInstance;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       D'tor of isegHalCache
+//------------------------------------------------------------------------------
+isegHalCache::~isegHalCache() {
+  std::map< std::string, isegCacheEntry* >::iterator it = _entries.begin();
+  for( ; it != _entries.end(); ++it ) delete it->second;
+  _entries.clear();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Subscribe a record to the shadow copy of its item
+//! @param [in]  interface  Name of the interface
+//! @param [in]  item       Item as read during record initialization
+//! @param [in]  pinfo      Address of the record's private data structure,
+//!                         NULL to only create the entry (array records)
+//! @return      Address of the cache entry
+//!
+//! Creates the entry if this is the first record of the item. Must only
+//! be called during record initialization, before the workers are started.
+//------------------------------------------------------------------------------
+isegCacheEntry* isegHalCache::subscribe( const char* interface, IsegItem const& item, devIsegHal_info_t* pinfo ) {
+  std::string key = std::string( interface ) + ":" + item.object;
+
+  epicsGuard< epicsMutex > guard( _lock );
+  std::map< std::string, isegCacheEntry* >::iterator it = _entries.find( key );
+  isegCacheEntry* entry = NULL;
+  if( it == _entries.end() ) {
+    entry = new isegCacheEntry;
+    strncpy( entry->object, item.object, FULLY_QUALIFIED_OBJECT_SIZE - 1 );
+    update( entry, item, 0. );
+    _entries[ key ] = entry;
+  } else {
+    entry = it->second;
+  }
+  if( pinfo ) entry->subscribers.push_back( pinfo );
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Update the shadow copy of an item
+//! @param [in]  entry  Address of the cache entry
+//! @param [in]  item   Item as read from isegHAL
+//! @param [in]  now    Time of the read (monotonic clock) [s]
+//! @return      true if the value has been changed in isegHAL
+//!
+//! Only the worker serving the item may update the entry. The timestamp
+//! is only decoded if the raw timestamp differs from the shadow copy.
+//------------------------------------------------------------------------------
+bool isegHalCache::update( isegCacheEntry* entry, IsegItem const& item, double now ) {
+  entry->refreshed = now;
+  if( strcmp( item.quality, ISEG_ITEM_QUALITY_OK ) != 0 ) {
+    epicsGuard< epicsMutex > guard( entry->lock );
+    memcpy( entry->quality, item.quality, QUALITY_SIZE );
+    return false;
+  }
+  if( 0 == strncmp( entry->rtime, item.timeStampLastChanged, TIME_SIZE )
+      && 0 == strncmp( entry->quality, item.quality, QUALITY_SIZE ) ) return false;
+
+  epicsTimeStamp time;
+  if( !decodeTime( item.timeStampLastChanged, time ) ) return false;
+
+  entry->lock.lock();
+  memcpy( entry->value, item.value, VALUE_SIZE );
+  memcpy( entry->quality, item.quality, QUALITY_SIZE );
+  memcpy( entry->rtime, item.timeStampLastChanged, TIME_SIZE );
+  entry->lock.unlock();
+  entry->time = time;
+  entry->changes++;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Decode the timestamp of an isegHAL item
+//! @param [in]  raw   timeStampLastChanged as received ("<seconds>.<fraction>")
+//! @param [out] time  Timestamp relative to the EPICS epoch
+//! @return      false if the timestamp could not be decoded
+//!
+//! The fraction is scaled by its number of digits, so that any resolution
+//! delivered by isegHAL maps to nanoseconds. Digits beyond nanoseconds
+//! are truncated.
+//------------------------------------------------------------------------------
+bool isegHalCache::decodeTime( const char* raw, epicsTimeStamp& time ) {
+  const char *p = raw;
+  const char *end = raw + TIME_SIZE;
+  epicsUInt32 seconds = 0;
+  while( p < end && *p >= '0' && *p <= '9' ) seconds = seconds * 10 + ( *p++ - '0' );
+  if( p == raw || p >= end || '.' != *p ) return false;
+
+  const char *frac = ++p;
+  epicsUInt32 nsec = 0;
+  unsigned digits = 0;
+  for( ; p < end && *p >= '0' && *p <= '9'; ++p ) {
+    if( digits < 9 ) {
+      nsec = nsec * 10 + ( *p - '0' );
+      ++digits;
+    }
+  }
+  if( p == frac || seconds < POSIX_TIME_AT_EPICS_EPOCH ) return false;
+  for( ; digits < 9; ++digits ) nsec *= 10;
+
+  time.secPastEpoch = seconds - POSIX_TIME_AT_EPICS_EPOCH;
+  time.nsec = nsec;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Find the shadow copy of an item
+//! @param [in]  interface  Name of the interface
+//! @param [in]  object     Fully qualified object name of the item
+//! @return      Address of the cache entry, NULL if no record uses the item
+//------------------------------------------------------------------------------
+isegCacheEntry* isegHalCache::find( std::string const& interface, std::string const& object ) {
+  epicsGuard< epicsMutex > guard( _lock );
+  std::map< std::string, isegCacheEntry* >::iterator it = _entries.find( interface + ":" + object );
+  return ( it == _entries.end() ) ? NULL : it->second;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Copy value and timestamp of a shadow copy
+//! @param [in]  entry  Address of the cache entry
+//! @param [out] value  Value cstring, VALUE_SIZE characters
+//! @param [out] rtime  Raw timestamp, TIME_SIZE characters
+//! @return      false if the quality of the item is not OK
+//!
+//! May be called by any thread while the worker updates the entry.
+//------------------------------------------------------------------------------
+bool isegHalCache::snapshot( isegCacheEntry* entry, char* value, char* rtime ) {
+  epicsGuard< epicsMutex > guard( entry->lock );
+  if( strcmp( entry->quality, ISEG_ITEM_QUALITY_OK ) != 0 ) return false;
+  memcpy( value, entry->value, VALUE_SIZE );
+  memcpy( rtime, entry->rtime, TIME_SIZE );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get all cache entries
+//! @return      Addresses of the cache entries
+//------------------------------------------------------------------------------
+std::vector< isegCacheEntry* > isegHalCache::entries() {
+  epicsGuard< epicsMutex > guard( _lock );
+  std::vector< isegCacheEntry* > result;
+  result.reserve( _entries.size() );
+  std::map< std::string, isegCacheEntry* >::iterator it = _entries.begin();
+  for( ; it != _entries.end(); ++it ) result.push_back( it->second );
+  return result;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get number of cached items
+//------------------------------------------------------------------------------
+size_t isegHalCache::size() {
+  epicsGuard< epicsMutex > guard( _lock );
+  return _entries.size();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get the key of the properties of an item
+//! @param [in]  interface  Name of the interface
+//! @param [in]  object     Fully qualified object name of the item
+//! @param [in]  session    isegHAL session used to read the article
+//! @return      Key in the property cache, empty if the item is not cached
+//!
+//! Module and channel items are keyed by the article of their module
+//! instead of line and module address, the article is read once per
+//! module. System and line items are keyed by their object name.
+//------------------------------------------------------------------------------
+std::string isegHalCache::propertyKey( std::string const& interface, std::string const& object, const char* session ) {
+  // count the leading address fields of <line>.<module>.<channel>.<item>
+  size_t pos = 0;
+  size_t module = std::string::npos;
+  unsigned fields = 0;
+  while( fields < 3 ) {
+    const char *begin = object.c_str() + pos;
+    char *end = NULL;
+    strtoul( begin, &end, 10 );
+    if( end == begin || '.' != *end ) break;
+    pos += end - begin + 1;
+    if( ++fields == 2 ) module = pos - 1;
+  }
+  if( fields < 2 ) return interface + ":" + object;
+
+  std::string key = interface + ":" + object.substr( 0, module );
+  std::string article;
+  {
+    epicsGuard< epicsMutex > guard( _lock );
+    std::map< std::string, std::string >::iterator it = _articles.find( key );
+    if( it != _articles.end() ) article = it->second;
+  }
+  if( article.empty() ) {
+    std::string item = object.substr( 0, module ) + ".Article";
+    IsegItem value = iseg_getItem( session, item.c_str() );
+    if( strcmp( value.quality, ISEG_ITEM_QUALITY_OK ) != 0 || '\0' == value.value[0] ) return std::string();
+    article = value.value;
+    epicsGuard< epicsMutex > guard( _lock );
+    _articles[ key ] = article;
+  }
+  return interface + ":" + article + ":" + ( fields == 3 ? "C." : "M." ) + object.substr( pos );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get the properties of an item
+//! @param [in]  interface  Name of the interface
+//! @param [in]  object     Fully qualified object name of the item
+//! @param [in]  session    isegHAL session to be used, default is the interface
+//! @return      Properties of the item
+//!
+//! Only the first record of an item on each module type reads the
+//! properties from isegHAL, the other records get a copy with their own
+//! object name.
+//------------------------------------------------------------------------------
+IsegItemProperty isegHalCache::property( std::string const& interface, std::string const& object, const char* session ) {
+  if( !session ) session = interface.c_str();
+  std::string key = propertyKey( interface, object, session );
+  if( !key.empty() ) {
+    epicsGuard< epicsMutex > guard( _lock );
+    std::map< std::string, IsegItemProperty >::iterator it = _properties.find( key );
+    if( it != _properties.end() ) {
+      IsegItemProperty prop = it->second;
+      memset( prop.object, 0, FULLY_QUALIFIED_OBJECT_SIZE );
+      strncpy( prop.object, object.c_str(), FULLY_QUALIFIED_OBJECT_SIZE - 1 );
+      return prop;
+    }
+  }
+
+  IsegItemProperty prop = iseg_getItemProperty( session, object.c_str() );
+  if( !key.empty() && strcmp( prop.quality, ISEG_ITEM_QUALITY_OK ) == 0 ) {
+    epicsGuard< epicsMutex > guard( _lock );
+    _properties[ key ] = prop;
+  }
+  return prop;
+}
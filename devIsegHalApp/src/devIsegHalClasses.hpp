@@ -29,12 +29,14 @@
 //_____ I N C L U D E S ________________________________________________________
 
 // ANSI C/C++ includes  */
-#include <list>
+#include <map>
 #include <string>
 #include <vector>
 
 // EPICS includes
 #include <dbAccess.h>
+#include <epicsEvent.h>
+#include <epicsMutex.h>
 #include <epicsThread.h>
 
 // local includes
@@ -42,6 +44,326 @@
 
 //_____ D E F I N I T I O N S __________________________________________________
 
+//! @brief   Type of request handled by the worker threads
+typedef enum {
+  GET_ITEM = 0,
+  SET_ITEM = 1,
+  SET_ITEM_GLOBAL = 2,
+  CLOSE_CONN = 3,
+  CHECK_EVENTS = 4,
+} devIsegHal_req_t;
+
+//! @brief   Priority lanes of the worker queues
+//!
+//! The workers always drain the higher lanes first
+typedef enum {
+  LANE_WRITE = 0,   //!< writes and emergency/broadcast commands
+  LANE_READ = 1,    //!< reads requested by record processing
+  LANE_POLL = 2,    //!< background reads of the polling thread
+  NUM_LANES = 3
+} devIsegHal_lane_t;
+
+//! @brief   Poll rate classes of the polling thread
+//!
+//! Each class has its own interval, items of class POLL_ONCE are only
+//! read during record initialization.
+typedef enum {
+  POLL_FAST = 0,    //!< e.g. measurements
+  POLL_NORMAL = 1,  //!< default, interval set with key "Intervall"
+  POLL_SLOW = 2,    //!< e.g. configuration
+  POLL_ONCE = 3,    //!< static items like serial numbers
+  NUM_POLL_CLASSES = 4
+} devIsegHal_poll_t;
+
+//! @brief   Entry of the poll schedule
+typedef struct {
+  double due;                 //!< next poll, monotonic clock [s]
+  double phase;               //!< nominal time of next poll, due may be later if deferred
+  double last;                //!< time of last poll, 0 if not yet polled
+  devIsegHal_info_t *pinfo;   //!< record handle
+  unsigned gen;               //!< pinfo->pollGen at registration
+} isegPollEntry_t;
+
+//! @brief   Order of the poll schedule (min-heap by due time)
+struct isegPollLater {
+  bool operator()( isegPollEntry_t const& a, isegPollEntry_t const& b ) const { return a.due > b.due; }
+};
+
+//! @brief   Period jitter statistics of a poll class
+typedef struct {
+  unsigned long count;        //!< number of periods
+  double sum;                 //!< sum of |actual - nominal period| [s]
+  double max;                 //!< max. of |actual - nominal period| [s]
+  unsigned long missed;       //!< polls more than one period late
+  unsigned long deferred;     //!< polls deferred because the worker was busy
+} isegPollStats_t;
+
+//! Period of the jitter report of the polling thread [s]
+#define ISEG_POLL_REPORT 10.
+//! Delay of polls for a busy worker [s]
+#define ISEG_POLL_BACKOFF 0.005
+//! Time to verify the values of a warm restart from the on-disk cache [s]
+#define ISEG_POLL_WARMUP 5.
+
+struct isegEventGroup;
+
+//! @brief   Message passed to the worker threads
+//!
+//! Messages only carry a handle to the record's private data, the value
+//! of a write request is kept in the write slot of the record.
+typedef struct {
+  union {
+    devIsegHal_info_t *pdata;       //!< record handle, NULL for CLOSE_CONN
+    struct isegEventGroup *pgroup;  //!< module to be checked for CHECK_EVENTS
+  };
+  epicsUInt32 reqType;        //!< devIsegHal_req_t
+  epicsUInt32 seq;            //!< sequence number of write requests
+} devIsegHal_msg_t;
+
+//! @brief   Bounded lock-free multi-producer single-consumer queue
+//!
+//! Ring buffer of worker messages with one sequence counter per cell.
+//! Any number of threads may push, only the owning worker pops.
+//! The capacity is rounded up to the next power of two.
+class isegHalRing {
+ public:
+  isegHalRing( unsigned capacity );
+  ~isegHalRing();
+
+  bool push( devIsegHal_msg_t const& msg );
+  bool pop( devIsegHal_msg_t& msg );
+  size_t pending() const;
+  inline size_t capacity() const { return _mask + 1; }
+
+ private:
+  isegHalRing( isegHalRing const& rother ); //!< copy constructor, not implemented
+  isegHalRing& operator=( isegHalRing const& rother ); //!< Copy assignment operator not implemented
+
+  struct cell_t {
+    size_t seq;
+    devIsegHal_msg_t msg;
+  };
+  cell_t *_cells;
+  size_t  _mask;
+  char    _pad0[64];          //!< keep producer and consumer index on separate cache lines
+  size_t  _head;              //!< next position to push
+  char    _pad1[64];
+  size_t  _tail;              //!< next position to pop
+};
+
+//! @brief   Shadow copy of an isegHAL item
+//!
+//! Holds the last value, quality and parsed timestamp of an item, so
+//! changes are detected once per item for all records using it.
+//! Only the worker serving the item writes the entry, other threads
+//! take a snapshot (isegHalCache::snapshot).
+struct isegCacheEntry {
+  isegCacheEntry();
+
+  char object[FULLY_QUALIFIED_OBJECT_SIZE];
+  char value[VALUE_SIZE];
+  char quality[QUALITY_SIZE];
+  char rtime[TIME_SIZE];      //!< timeStampLastChanged as received
+  epicsTimeStamp time;        //!< parsed timeStampLastChanged
+  double refreshed;           //!< time of last read, monotonic clock [s]
+  unsigned long changes;      //!< number of detected changes
+  double phase;               //!< poll phase of the records, < 0 if not yet polled
+  std::vector< devIsegHal_info_t* > subscribers;  //!< records using this item
+  epicsMutex lock;            //!< protects value, quality and rtime against snapshots
+};
+
+//! Max. age of a shadow copy to serve a poll without reading isegHAL [s]
+#define ISEG_CACHE_MAXAGE 0.05
+
+//! @brief   Item of all channels of a module, served as one array
+//!
+//! Used by array records with link "@<line>.<module>.*.<item> <Interface>".
+//! The channel items are shared with the scalar records via the cache.
+struct isegArray {
+  std::vector< isegCacheEntry* > entries;  //!< shadow copies of the channel items
+  std::vector< epicsFloat64 > values;      //!< values as of the last update of the record
+  unsigned long changes;                   //!< sum of the changes of the channel items as of the last update
+  epicsMutex lock;                         //!< protects values
+  std::vector< epicsFloat64 > staged;      //!< values to be written, set by record processing
+  std::vector< epicsFloat64 > wvalues;     //!< write slot, protected by the write lock of the record
+};
+
+//! @brief   I/O Intr scan list shared by the records of a channel
+//!
+//! Module items have one list per module, system and line items one list
+//! per interface or line. All items of a list are served by the same
+//! worker, which issues the scan once for all records of the list updated
+//! by a batch of requests. Only this worker accesses queued.
+struct isegScanGroup {
+  IOSCANPVT ioscanpvt;
+  bool queued;                             //!< scan has been requested by the worker, not yet issued
+  unsigned shard;                          //!< worker serving the list
+};
+
+//! Max. number of requests handled by a worker before requested scans are issued
+#define ISEG_SCAN_BATCH 32
+
+//! @brief   Cache of the shadow copies of all items in use
+//!
+//! Entries are created during record initialization and are updated
+//! only by the worker serving the item.
+//! The cache also holds the properties of the items, which are the same
+//! for an item on all modules or channels of a module type (Article).
+//! This class uses the singleton design pattern
+class isegHalCache {
+ public:
+  static isegHalCache& instance();
+
+  isegCacheEntry* subscribe( const char* interface, IsegItem const& item, devIsegHal_info_t* pinfo );
+  bool update( isegCacheEntry* entry, IsegItem const& item, double now );
+  isegCacheEntry* find( std::string const& interface, std::string const& object );
+  bool snapshot( isegCacheEntry* entry, char* value, char* rtime );
+  std::vector< isegCacheEntry* > entries();
+  size_t size();
+
+  IsegItemProperty property( std::string const& interface, std::string const& object, const char* session = NULL );
+
+  static bool decodeTime( const char* raw, epicsTimeStamp& time );
+
+ private:
+  isegHalCache() {};
+  ~isegHalCache();
+  isegHalCache( isegHalCache const& rother ); //!< copy constructor, not implemented
+  isegHalCache& operator=( isegHalCache const& rother ); //!< Copy assignment operator not implemented
+
+  std::string propertyKey( std::string const& interface, std::string const& object, const char* session );
+
+  std::map< std::string, isegCacheEntry* > _entries;  //!< key is "<interface>:<object>"
+  std::map< std::string, std::string > _articles;     //!< key is "<interface>:<line>.<module>"
+  std::map< std::string, IsegItemProperty > _properties; //!< key is "<interface>:<article>:<M|C>.<item>"
+  epicsMutex _lock;
+};
+
+//! @brief   Identity of a module in the on-disk cache, empty for system and line items
+typedef struct {
+  char firmware[ VALUE_SIZE ];  //!< FirmwareName
+  char article[ VALUE_SIZE ];   //!< Article
+  char serial[ VALUE_SIZE ];    //!< SerialNumber
+} isegDiskModule_t;
+
+//! @brief   Entry of the on-disk cache
+typedef struct {
+  char key[ FULLY_QUALIFIED_OBJECT_SIZE + 32 ]; //!< "<interface>:<object>"
+  char controller[ VALUE_SIZE ]; //!< hardware interface of <interface> when the cache was written
+  isegDiskModule_t module;      //!< module of the item when the cache was written
+  IsegItemProperty prop;
+  char value[ VALUE_SIZE ];
+  char rtime[ TIME_SIZE ];
+} isegDiskEntry_t;
+
+//! @brief   Header of the on-disk cache
+typedef struct {
+  char magic[8];              //!< ISEG_DISK_MAGIC
+  epicsUInt32 version;        //!< ISEG_DISK_VERSION
+  epicsUInt32 count;          //!< number of entries following the header
+} isegDiskHeader_t;
+
+#define ISEG_DISK_MAGIC   "ISEGHAL"
+#define ISEG_DISK_VERSION 3
+
+//! @brief   Persistent copy of item properties and values
+//!
+//! Written after iocInit and at exit, if a file has been set. On the next
+//! boot records are initialized from the memory-mapped file without
+//! reading isegHAL, if their interface is connected to the same hardware
+//! interface as before and FirmwareName, Article and SerialNumber of the
+//! module are unchanged.
+//! These records are flagged stale until they are read from isegHAL.
+//! This class uses the singleton design pattern
+class isegHalDiskCache {
+ public:
+  static isegHalDiskCache& instance();
+
+  void setFile( std::string const& path );
+  bool lookup( std::string const& interface, std::string const& object, IsegItemProperty& prop, IsegItem& item );
+  void remember( std::string const& interface, IsegItemProperty const& prop );
+  bool save();
+
+ private:
+  isegHalDiskCache();
+  ~isegHalDiskCache();
+  isegHalDiskCache( isegHalDiskCache const& rother ); //!< copy constructor, not implemented
+  isegHalDiskCache& operator=( isegHalDiskCache const& rother ); //!< Copy assignment operator not implemented
+
+  bool load();
+  void unload();
+  bool moduleValid( std::string const& interface, std::string const& object, isegDiskModule_t const& module );
+
+  std::string _path;          //!< file name, empty if disabled
+  bool _loaded;               //!< load has been tried
+  void *_base;                //!< mapped file
+  size_t _size;
+  std::map< std::string, isegDiskEntry_t const* > _index;  //!< entries of the mapped file
+  std::map< std::string, bool > _modules;   //!< result of the firmware check per module
+  std::map< std::string, IsegItemProperty > _props;  //!< properties of the records in this IOC
+  epicsMutex _lock;
+};
+
+//! @brief   Concurrent read of the items of all records before record init
+//!
+//! The items are taken from the INP/OUT links of all records with DTYP
+//! "isegHAL", grouped by line and module and read over several sessions
+//! in parallel. Properties end up in isegHalCache, values are kept until
+//! the records are initialized.
+//! This class uses the singleton design pattern
+class isegHalPrefetch {
+ public:
+  static isegHalPrefetch& instance();
+
+  inline void setSessions( unsigned sessions ) { _sessions = sessions; }
+  void run();
+  bool take( std::string const& interface, std::string const& object, IsegItem& item );
+  void clear();
+
+ private:
+  isegHalPrefetch() : _sessions( 0 ) {};
+  ~isegHalPrefetch() {};
+  isegHalPrefetch( isegHalPrefetch const& rother ); //!< copy constructor, not implemented
+  isegHalPrefetch& operator=( isegHalPrefetch const& rother ); //!< Copy assignment operator not implemented
+
+  static void fetch( void* arg );
+
+  unsigned _sessions;         //!< number of sessions per interface, 0 to disable
+  std::map< std::string, IsegItem > _items;  //!< values, key is "<interface>:<object>"
+  epicsMutex _lock;
+};
+
+//! @brief   EventStatus word of a module or channel watched in event mode
+struct isegEventWord {
+  std::string status;         //!< object of the EventStatus item
+  isegCacheEntry *pstatus;    //!< shadow copy of the EventStatus item, NULL if not used by records
+  std::vector< devIsegHal_info_t* > members;  //!< one polled record of each item of the module/channel
+  epicsUInt32 last;           //!< word of the previous check, new events are bits set since then
+  unsigned long events;       //!< number of events seen
+};
+
+//! @brief   Module watched in event mode
+//!
+//! The EventStatus words of the module and its channels are checked by
+//! the worker serving the module. If a new event is set, the items of
+//! the module or channel are read immediately. The events are only
+//! cleared if requested (EventMode 2), they are left for the operator
+//! otherwise.
+struct isegEventGroup {
+  std::string clear;          //!< object of the doClear bit of the module
+  std::vector< isegEventWord > words;
+  unsigned shard;             //!< worker serving the module
+  int inflight;               //!< check is queued
+  bool autoClear;             //!< clear the events after reading the items
+};
+
+//! Max. time to wait for isegHAL to provide data after connect [s]
+#define ISEG_READY_TIMEOUT 5.
+//! Interval to check if isegHAL provides data [s]
+#define ISEG_READY_POLL 0.05
+//! Max. time to drain the worker queues on shutdown [s]
+#define ISEG_SHUTDOWN_TIMEOUT 2.
+
 //! @brief   Handler for iseg interfaces
 //!
 //! This class handles the connection of the used
@@ -60,16 +382,25 @@ class isegHalConnectionHandler {
 	 std::string getName();
 	 void setName( std::string name );
 	 void storeHalNames( std::vector<std::string> &dstinterfaces );
+  void registerInterface( std::string const& name, std::string const& interface );
+  size_t numInterfaces();
+  int indexOf( std::string const& name );
+  std::string getName( size_t index );
+  std::string getHalInterface( size_t index );
 
  private:
   isegHalConnectionHandler() {};
   ~isegHalConnectionHandler();
+  bool waitReady( std::string const& name );
   isegHalConnectionHandler( isegHalConnectionHandler const& rother ); //!< copy constructor, not implemented
   isegHalConnectionHandler& operator=( isegHalConnectionHandler const& rother ); //!< Copy assignment operator not implemented
 
   std::vector< std::string > _interfaces;
+  epicsMutex _lock;
 	std::string _halInterface;
 	std::string _name;
+  std::vector< std::string > _names;         //!< interfaces connected by isegHalConnect, in order
+  std::vector< std::string > _halInterfaces; //!< hardware interfaces of _names
 };
 
 //! @brief   thread monitoring set values from isegHAL
@@ -85,22 +416,132 @@ class isegHalThread: public epicsThreadRunable {
   epicsThread thread;
 
   void registerInterrupt( dbCommon* prec, devIsegHal_info_t* pinfo );
-  void cancelInterrupt( const devIsegHal_info_t* pinfo );
+  void cancelInterrupt( devIsegHal_info_t* pinfo );
 
-  inline void changeIntervall( double val ) { _pause = val; }
-  inline double getIntervall(){ return _pause; }
+  inline void changeIntervall( double val, devIsegHal_poll_t cls = POLL_NORMAL ) { _pause[cls] = val; _wakeup.signal(); }
+  inline double getIntervall( devIsegHal_poll_t cls = POLL_NORMAL ){ return _pause[cls]; }
 
   inline void setDbgLvl( int dbglvl ) { _debug = dbglvl; }
   inline void disable() { _run = false; }
   inline void enable() { _run = true; }
 
+  inline void setEventMode( unsigned mode ) { _eventMode = mode; _wakeup.signal(); }
+  inline void changeEventIntervall( double val ) { _eventPause = val; _wakeup.signal(); }
+  bool stop( double timeout );
+
  private:
+  void buildEventGroups();
+  double interval( devIsegHal_info_t const* pinfo ) const;
+  std::vector< devIsegHal_info_t* > const& snapshot();
+
   bool _run;
-  double _pause;
+  int _exit;                  //!< stop the thread, accessed atomically
+  double _pause[ NUM_POLL_CLASSES ];  //!< interval of each poll class
+  unsigned _eventMode;        //!< 1: watch EventStatus words and read items on events, 2: and clear the events
+  double _eventPause;         //!< interval of the EventStatus checks
+  double _eventDue;           //!< time of the next EventStatus check
+  std::vector< isegEventGroup* > _groups;
+  std::vector< isegEventGroup* > _retired;       //!< groups replaced by a rebuild, deleted when no check is queued
+  unsigned _groupsVersion;    //!< version of _recs in _groups
   unsigned _debug;
-  std::list< devIsegHal_info_t* > _recs;
+  std::vector< devIsegHal_info_t* > _recs;       //!< registered records, unordered
+  unsigned _recsVersion;      //!< incremented on each change of _recs
+  std::vector< devIsegHal_info_t* > _snapshot;   //!< copy of _recs used by the thread
+  unsigned _snapshotVersion;  //!< version of _recs in _snapshot
+  std::vector< isegPollEntry_t > _schedule;      //!< min-heap of poll deadlines
+  isegPollStats_t _stats[ NUM_POLL_CLASSES ];
+  unsigned long _registered[ NUM_POLL_CLASSES ]; //!< records ever registered, for phase
+  epicsMutex _lock;           //!< protects _recs, _schedule and _stats
+  epicsEvent _wakeup;         //!< new record registered or interval changed
+  epicsEvent _done;           //!< thread has been stopped
+};
+
+//! @brief   worker thread serving the isegHAL requests of one shard
+//!
+//! Each worker owns a lock-free request queue for each priority lane
+//! (devIsegHal_lane_t) and its own session to the isegHAL server.
+//! Items are assigned to a worker by CAN line and module, so all
+//! requests for one module are handled by the same worker in order, while
+//! slow requests on one module no longer block the others.
+class isegHalWorker: public epicsThreadRunable {
+ public:
+  isegHalWorker( unsigned index, std::string const& session, std::string const& interface,
+                 const unsigned* depths );
+  virtual ~isegHalWorker();
+  virtual void run();
+  epicsThread thread;
+
+  bool request( devIsegHal_info_t* pinfo, devIsegHal_req_t req, devIsegHal_lane_t lane, epicsUInt32 seq = 0 );
+  bool request( isegEventGroup* pgroup );
+  inline std::string const& getSession() const { return _session; }
+  inline size_t pending( devIsegHal_lane_t lane ) const { return _lanes[lane]->pending(); }
+  inline size_t capacity( devIsegHal_lane_t lane ) const { return _lanes[lane]->capacity(); }
+  inline bool waitReady( double timeout ) { return epicsEventOK == epicsEventWaitWithTimeout( _ready, timeout ); }
+  inline bool waitDone( double timeout ) { return epicsEventOK == epicsEventWaitWithTimeout( _done, timeout ); }
+
+ private:
+  bool post( devIsegHal_msg_t const& msg, devIsegHal_lane_t lane );
+  bool receive( devIsegHal_msg_t& msg );
+  inline bool idle() const {
+    for( unsigned i = 0; i < NUM_LANES; ++i ) if( _lanes[i]->pending() ) return false;
+    return true;
+  }
+  void checkEvents( isegEventGroup* pgroup );
+  void getItem( devIsegHal_info_t* pinfo );
+  void getArray( devIsegHal_info_t* pinfo );
+  void setItem( devIsegHal_info_t* pinfo );
+  void setArray( devIsegHal_info_t* pinfo );
+  void setItemGlobal( devIsegHal_info_t* pinfo );
+  void deliver( devIsegHal_info_t* pinfo );
+  void deliverUpdate( devIsegHal_info_t* pinfo );
+  void requestScans();
+
+  unsigned _index;
+  std::string _session;
+  std::string _interface;
+  isegHalRing* _lanes[ NUM_LANES ];
+  epicsEventId _wakeup;
+  epicsEventId _ready;        //!< session is connected
+  epicsEventId _done;         //!< session is closed
+  int _sleeping;              //!< worker waits for _wakeup
+  std::vector< isegScanGroup* > _scans; //!< scan lists with updated records
+  unsigned _handled;          //!< requests handled since the scans have been issued
 };
 
+//! Min. number of completed records each dispatcher thread can hold
+#define ISEG_DISPATCH_DEPTH 4096
+//! Max. number of completed records processed by a dispatcher thread at once
+#define ISEG_DISPATCH_BATCH 64
+
+//! @brief   Thread processing the records completed by the workers
+//!
+//! Replaces the EPICS callback queue for devIsegHal. The completed records
+//! are taken from the queue in batches and processed back-to-back. Each
+//! record is always dispatched to the same thread.
+class isegHalDispatcher: public epicsThreadRunable {
+ public:
+  isegHalDispatcher( unsigned index, unsigned priority );
+  virtual ~isegHalDispatcher();
+  virtual void run();
+  epicsThread thread;
+
+  bool request( devIsegHal_info_t* pinfo );
+  void stop();
+  size_t completed() const;
+  size_t batches() const;
+
+ private:
+  isegHalDispatcher( isegHalDispatcher const& rother ); //!< copy constructor, not implemented
+  isegHalDispatcher& operator=( isegHalDispatcher const& rother ); //!< Copy assignment operator not implemented
+
+  unsigned _index;
+  isegHalRing _queue;
+  epicsEventId _wakeup;
+  int _sleeping;              //!< dispatcher waits for _wakeup
+  int _exit;                  //!< stop the thread, accessed atomically
+  size_t _completed;          //!< number of processed records
+  size_t _batches;            //!< number of processed batches
+};
 
 class isegHalTaskThread: public epicsThreadRunable {
  public:
@@ -0,0 +1,355 @@
+//******************************************************************************
+// Copyright (C) 2015 Florian Feldbauer <f.feldbauer@him.uni-mainz.de>
+//                    - Helmholtz-Institut Mainz
+//                    iseg Spezialelektronik GmbH
+//
+// This file is part of deviseg
+//
+// deviseg is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// deviseg is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// version 2.0.0; May 25, 2015
+//
+//******************************************************************************
+
+
+//! @file devIsegHalDiskCache.cpp
+//! @brief Persistent copy of item properties and values for warm restarts
+
+//_____ I N C L U D E S ________________________________________________________
+
+// ANSI C/C++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// EPICS includes
+#include <epicsExit.h>
+#include <epicsGuard.h>
+#include <initHooks.h>
+
+// local includes
+#include "devIsegHalClasses.hpp"
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+//_____ G L O B A L S __________________________________________________________
+
+//_____ L O C A L S ____________________________________________________________
+
+//_____ F U N C T I O N S ______________________________________________________
+
+//------------------------------------------------------------------------------
+//! @brief       Get the module part of an object name
+//! @param [in]  object  Fully qualified object name of the item
+//! @return      "<line>.<module>", empty for system and line items
+//------------------------------------------------------------------------------
+static std::string isegModuleOf( std::string const& object ) {
+  const char *begin = object.c_str();
+  char *end = NULL;
+  strtoul( begin, &end, 10 );
+  if( end == begin || '.' != *end ) return std::string();
+  const char *pmod = end + 1;
+  strtoul( pmod, &end, 10 );
+  if( end == pmod || '.' != *end ) return std::string();
+  return object.substr( 0, end - begin );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get the hardware interface of an interface
+//! @param [in]  interface  deviseg internal name of the interface handle
+//! @return      Hardware interface, empty if the interface is not registered
+//------------------------------------------------------------------------------
+static std::string isegControllerOf( std::string const& interface ) {
+  isegHalConnectionHandler& handler = isegHalConnectionHandler::instance();
+  int index = handler.indexOf( interface );
+  return ( index < 0 ) ? std::string() : handler.getHalInterface( index );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Write the cache after iocInit
+//------------------------------------------------------------------------------
+static void isegDiskCacheHook( initHookState state ) {
+  if( initHookAfterIocRunning == state ) isegHalDiskCache::instance().save();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Write the cache at exit
+//------------------------------------------------------------------------------
+static void isegDiskCacheExit( void* ) {
+  isegHalDiskCache::instance().save();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get reference to the on-disk cache
+//------------------------------------------------------------------------------
+isegHalDiskCache& isegHalDiskCache::instance() {
+  static isegHalDiskCache myInstance;
+  return myInstance;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       C'tor of isegHalDiskCache
+//------------------------------------------------------------------------------
+isegHalDiskCache::isegHalDiskCache()
+  : _loaded( false ),
+    _base( NULL ),
+    _size( 0 )
+{}
+
+//------------------------------------------------------------------------------
+//! @brief       D'tor of isegHalDiskCache
+//------------------------------------------------------------------------------
+isegHalDiskCache::~isegHalDiskCache() {
+  unload();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Set the file of the cache
+//! @param [in]  path  File name, has to be set before iocInit
+//------------------------------------------------------------------------------
+void isegHalDiskCache::setFile( std::string const& path ) {
+  static bool firstTime = true;
+  _path = path;
+  if( firstTime ) {
+    initHookRegister( isegDiskCacheHook );
+    epicsAtExit( isegDiskCacheExit, NULL );
+    firstTime = false;
+  }
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Map the cache file
+//! @return      false if there is no valid cache file
+//!
+//! Must be called with _lock held.
+//------------------------------------------------------------------------------
+bool isegHalDiskCache::load() {
+  _loaded = true;
+  int fd = open( _path.c_str(), O_RDONLY );
+  if( fd < 0 ) return false;
+
+  struct stat st;
+  if( 0 != fstat( fd, &st ) || (size_t)st.st_size < sizeof( isegDiskHeader_t ) ) {
+    close( fd );
+    return false;
+  }
+  void *base = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close( fd );
+  if( MAP_FAILED == base ) return false;
+
+  isegDiskHeader_t const* header = (isegDiskHeader_t const*)base;
+  if( 0 != memcmp( header->magic, ISEG_DISK_MAGIC, sizeof( ISEG_DISK_MAGIC ) )
+      || ISEG_DISK_VERSION != header->version
+      || (size_t)st.st_size != sizeof( isegDiskHeader_t ) + header->count * sizeof( isegDiskEntry_t ) ) {
+    fprintf( stderr, "\033[31;1mIgnoring isegHAL cache '%s', written by another version\033[0m\n", _path.c_str() );
+    munmap( base, st.st_size );
+    return false;
+  }
+
+  _base = base;
+  _size = st.st_size;
+  isegDiskEntry_t const* entries = (isegDiskEntry_t const*)( header + 1 );
+  for( epicsUInt32 i = 0; i < header->count; ++i ) {
+    _index[ std::string( entries[i].key, strnlen( entries[i].key, sizeof( entries[i].key ) ) ) ] = &entries[i];
+  }
+  printf( "Loaded %u items from isegHAL cache '%s'\n", header->count, _path.c_str() );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Unmap the cache file
+//------------------------------------------------------------------------------
+void isegHalDiskCache::unload() {
+  _index.clear();
+  if( _base ) munmap( _base, _size );
+  _base = NULL;
+  _size = 0;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Check if the cached items of a module are still valid
+//! @param [in]  interface  Name of the interface
+//! @param [in]  object     Fully qualified object name of the item
+//! @param [in]  module     Identity of the module when the cache was written
+//! @return      true if it is the same module with the same firmware as before
+//!
+//! FirmwareName, Article and SerialNumber are read once per module.
+//------------------------------------------------------------------------------
+bool isegHalDiskCache::moduleValid( std::string const& interface, std::string const& object, isegDiskModule_t const& module ) {
+  std::string address = isegModuleOf( object );
+  if( address.empty() ) return true; // system and line items
+  std::string key = interface + ":" + address;
+  {
+    epicsGuard< epicsMutex > guard( _lock );
+    std::map< std::string, bool >::iterator it = _modules.find( key );
+    if( it != _modules.end() ) return it->second;
+  }
+  static const char* items[] = { ".FirmwareName", ".Article", ".SerialNumber" };
+  const char* expected[] = { module.firmware, module.article, module.serial };
+  bool valid = true;
+  for( unsigned i = 0; valid && i < sizeof( items ) / sizeof( items[0] ); ++i ) {
+    std::string item = address + items[i];
+    IsegItem value = iseg_getItem( interface.c_str(), item.c_str() );
+    valid = ( strcmp( value.quality, ISEG_ITEM_QUALITY_OK ) == 0 && strncmp( value.value, expected[i], VALUE_SIZE ) == 0 );
+  }
+  if( !valid )
+    fprintf( stderr, "\033[31;1mModule %s or its firmware changed, not using isegHAL cache\033[0m\n", address.c_str() );
+  epicsGuard< epicsMutex > guard( _lock );
+  _modules[ key ] = valid;
+  return valid;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get properties and value of an item from the cache file
+//! @param [in]  interface  Name of the interface
+//! @param [in]  object     Fully qualified object name of the item
+//! @param [out] prop       Properties of the item
+//! @param [out] item       Last known value of the item
+//! @return      false if the item has to be read from isegHAL
+//!
+//! Items of interfaces that are not registered or that are now connected
+//! to another hardware interface are not used.
+//------------------------------------------------------------------------------
+bool isegHalDiskCache::lookup( std::string const& interface, std::string const& object, IsegItemProperty& prop, IsegItem& item ) {
+  if( _path.empty() ) return false;
+  isegDiskEntry_t const* entry = NULL;
+  {
+    epicsGuard< epicsMutex > guard( _lock );
+    if( !_loaded ) load();
+    std::map< std::string, isegDiskEntry_t const* >::iterator it = _index.find( interface + ":" + object );
+    if( it == _index.end() ) return false;
+    entry = it->second;
+  }
+  std::string controller = isegControllerOf( interface );
+  if( controller.empty() || 0 != strncmp( entry->controller, controller.c_str(), VALUE_SIZE ) ) return false;
+  if( !moduleValid( interface, object, entry->module ) ) return false;
+
+  prop = entry->prop;
+  item = EmptyIsegItem;
+  strncpy( item.object, object.c_str(), FULLY_QUALIFIED_OBJECT_SIZE - 1 );
+  memcpy( item.value, entry->value, VALUE_SIZE );
+  strncpy( item.quality, ISEG_ITEM_QUALITY_OK, QUALITY_SIZE - 1 );
+  memcpy( item.timeStampLastChanged, entry->rtime, TIME_SIZE );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Add an item used by a record to the next cache file
+//! @param [in]  interface  Name of the interface
+//! @param [in]  prop       Properties of the item
+//------------------------------------------------------------------------------
+void isegHalDiskCache::remember( std::string const& interface, IsegItemProperty const& prop ) {
+  if( _path.empty() ) return;
+  epicsGuard< epicsMutex > guard( _lock );
+  _props[ interface + ":" + prop.object ] = prop;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get the identity of a module from the shadow copies
+//! @param [in]  interface  Name of the interface
+//! @param [in]  module     "<line>.<module>"
+//! @param [out] identity   FirmwareName, Article and SerialNumber of the module
+//! @return      false if one of the items is not used by a record
+//------------------------------------------------------------------------------
+static bool isegModuleIdentity( std::string const& interface, std::string const& module, isegDiskModule_t& identity ) {
+  static const char* items[] = { ".FirmwareName", ".Article", ".SerialNumber" };
+  char* values[] = { identity.firmware, identity.article, identity.serial };
+  char rtime[ TIME_SIZE ];
+  for( unsigned i = 0; i < sizeof( items ) / sizeof( items[0] ); ++i ) {
+    isegCacheEntry* cached = isegHalCache::instance().find( interface, module + items[i] );
+    if( !cached || !isegHalCache::instance().snapshot( cached, values[i], rtime ) ) return false;
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Write properties and last known values of all items in use
+//! @return      false if the file could not be written
+//!
+//! The values are taken from snapshots of the shadow copies in isegHalCache,
+//! as the workers are running. Items of modules without records of their
+//! FirmwareName, Article and SerialNumber and items of interfaces that are
+//! not registered are not written, as they could not be checked on the
+//! next boot. The file is replaced atomically.
+//------------------------------------------------------------------------------
+bool isegHalDiskCache::save() {
+  if( _path.empty() ) return false;
+  std::map< std::string, IsegItemProperty > props;
+  {
+    epicsGuard< epicsMutex > guard( _lock );
+    unload(); // records are initialized
+    props = _props;
+  }
+  if( props.empty() ) return false; // keep the file of the last run
+
+  std::vector< isegDiskEntry_t > entries;
+  entries.reserve( props.size() );
+  std::map< std::string, IsegItemProperty >::iterator it = props.begin();
+  for( ; it != props.end(); ++it ) {
+    size_t colon = it->first.find( ':' );
+    std::string interface = it->first.substr( 0, colon );
+    std::string object = it->first.substr( colon + 1 );
+    std::string controller = isegControllerOf( interface );
+    isegCacheEntry* cached = isegHalCache::instance().find( interface, object );
+    if( controller.empty() || !cached ) continue;
+
+    isegDiskEntry_t entry;
+    memset( &entry, 0, sizeof( entry ) );
+    if( !isegHalCache::instance().snapshot( cached, entry.value, entry.rtime ) ) continue;
+    std::string module = isegModuleOf( object );
+    if( !module.empty() && !isegModuleIdentity( interface, module, entry.module ) ) continue;
+    strncpy( entry.key, it->first.c_str(), sizeof( entry.key ) - 1 );
+    strncpy( entry.controller, controller.c_str(), VALUE_SIZE - 1 );
+    entry.prop = it->second;
+    entries.push_back( entry );
+  }
+
+  isegDiskHeader_t header;
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.magic, ISEG_DISK_MAGIC, sizeof( ISEG_DISK_MAGIC ) );
+  header.version = ISEG_DISK_VERSION;
+  header.count = entries.size();
+
+  std::string tmp = _path + ".tmp";
+  size_t size = sizeof( header ) + entries.size() * sizeof( isegDiskEntry_t );
+  int fd = open( tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 );
+  if( fd < 0 || 0 != ftruncate( fd, size ) ) {
+    fprintf( stderr, "\033[31;1mCannot write isegHAL cache '%s'\033[0m\n", tmp.c_str() );
+    if( fd >= 0 ) close( fd );
+    return false;
+  }
+  void *base = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+  close( fd );
+  if( MAP_FAILED == base ) {
+    fprintf( stderr, "\033[31;1mCannot write isegHAL cache '%s'\033[0m\n", tmp.c_str() );
+    return false;
+  }
+  memcpy( base, &header, sizeof( header ) );
+  if( !entries.empty() )
+    memcpy( (char*)base + sizeof( header ), &entries[0], entries.size() * sizeof( isegDiskEntry_t ) );
+  msync( base, size, MS_SYNC );
+  munmap( base, size );
+
+  if( 0 != rename( tmp.c_str(), _path.c_str() ) ) {
+    fprintf( stderr, "\033[31;1mCannot write isegHAL cache '%s'\033[0m\n", _path.c_str() );
+    return false;
+  }
+  return true;
+}
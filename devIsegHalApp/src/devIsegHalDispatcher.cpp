@@ -0,0 +1,139 @@
+//******************************************************************************
+// Copyright (C) 2015 Florian Feldbauer <f.feldbauer@him.uni-mainz.de>
+//                    - Helmholtz-Institut Mainz
+//                    iseg Spezialelektronik GmbH
+//
+// This file is part of deviseg
+//
+// deviseg is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// deviseg is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// version 2.0.0; May 25, 2015
+//
+//******************************************************************************
+
+
+//! @file devIsegHalDispatcher.cpp
+//! @brief Threads processing the records completed by the workers
+
+//_____ I N C L U D E S ________________________________________________________
+
+// ANSI C/C++ includes
+
+// EPICS includes
+#include <epicsAtomic.h>
+
+// local includes
+#include "devIsegHalClasses.hpp"
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+//_____ G L O B A L S __________________________________________________________
+
+//_____ L O C A L S ____________________________________________________________
+
+//_____ F U N C T I O N S ______________________________________________________
+
+//------------------------------------------------------------------------------
+//! @brief       C'tor of isegHalDispatcher
+//! @param [in]  index     Index of the dispatcher
+//! @param [in]  priority  EPICS priority of the thread
+//------------------------------------------------------------------------------
+isegHalDispatcher::isegHalDispatcher( unsigned index, unsigned priority )
+  : thread( *this, "isegDispatch", epicsThreadGetStackSize( epicsThreadStackBig ), priority ),
+    _index( index ),
+    _queue( ISEG_DISPATCH_DEPTH ),
+    _wakeup( NULL ),
+    _sleeping( 0 ),
+    _exit( 0 ),
+    _completed( 0 ),
+    _batches( 0 )
+{
+  _wakeup = epicsEventMustCreate( epicsEventEmpty );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       D'tor of isegHalDispatcher
+//------------------------------------------------------------------------------
+isegHalDispatcher::~isegHalDispatcher() {
+  epicsEventDestroy( _wakeup );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Queue a completed record
+//! @param [in]  pinfo  Address of the record's private data structure
+//! @return      false if the queue is full
+//!
+//! May be called by any thread.
+//------------------------------------------------------------------------------
+bool isegHalDispatcher::request( devIsegHal_info_t* pinfo ) {
+  devIsegHal_msg_t msg;
+  msg.pdata = pinfo;
+  msg.reqType = GET_ITEM;
+  msg.seq = 0;
+  if( !_queue.push( msg ) ) return false;
+
+  // full barrier: publish the record before looking at the thread's state
+  if( epicsAtomicAddIntT( &_sleeping, 0 ) ) epicsEventSignal( _wakeup );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Stop the thread after the current batch
+//------------------------------------------------------------------------------
+void isegHalDispatcher::stop() {
+  epicsAtomicSetIntT( &_exit, 1 );
+  epicsEventSignal( _wakeup );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get number of processed records
+//------------------------------------------------------------------------------
+size_t isegHalDispatcher::completed() const {
+  return epicsAtomicGetSizeT( &_completed );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get number of processed batches
+//------------------------------------------------------------------------------
+size_t isegHalDispatcher::batches() const {
+  return epicsAtomicGetSizeT( &_batches );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Run operation of dispatcher thread
+//!
+//! Takes up to ISEG_DISPATCH_BATCH records from the queue and processes
+//! them back-to-back, each one with its own scan lock.
+//------------------------------------------------------------------------------
+void isegHalDispatcher::run() {
+  devIsegHal_info_t* batch[ ISEG_DISPATCH_BATCH ];
+  devIsegHal_msg_t msg;
+  while( !epicsAtomicGetIntT( &_exit ) ) {
+    unsigned n = 0;
+    while( n < ISEG_DISPATCH_BATCH && _queue.pop( msg ) ) batch[ n++ ] = msg.pdata;
+    if( 0 == n ) {
+      // announce the wait, then look again to not miss a record
+      // queued in between
+      epicsAtomicCmpAndSwapIntT( &_sleeping, 0, 1 );
+      if( 0 == _queue.pending() && !epicsAtomicGetIntT( &_exit ) ) epicsEventWait( _wakeup );
+      epicsAtomicSetIntT( &_sleeping, 0 );
+      continue;
+    }
+
+    for( unsigned i = 0; i < n; ++i ) devIsegHalProcess( batch[i]->precord );
+    epicsAtomicAddSizeT( &_completed, n );
+    epicsAtomicIncrSizeT( &_batches );
+  }
+}
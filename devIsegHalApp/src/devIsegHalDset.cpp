@@ -0,0 +1,505 @@
+//******************************************************************************
+// Copyright (C) 2015 Florian Feldbauer <f.feldbauer@him.uni-mainz.de>
+//                    - Helmholtz-Institut Mainz
+//                    iseg Spezialelektronik GmbH
+//
+// This file is part of deviseg
+//
+// deviseg is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// deviseg is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// version 2.0.0; May 25, 2015
+//
+//******************************************************************************
+
+
+//! @file devIsegHalDset.cpp
+//! @brief Device support of the records served by isegHAL
+//!
+//! Each record type is described by a traits class, the dset routines are
+//! generated by isegDset.
+
+//_____ I N C L U D E S ________________________________________________________
+
+// ANSI C/C++ includes
+#include <cstdio>
+#include <cstring>
+
+// EPICS includes
+#include <aaiRecord.h>
+#include <aaoRecord.h>
+#include <aiRecord.h>
+#include <aoRecord.h>
+#include <biRecord.h>
+#include <boRecord.h>
+#include <cantProceed.h>
+#include <dbAccess.h>
+#include <epicsExport.h>
+#include <epicsGuard.h>
+#include <longinRecord.h>
+#include <longoutRecord.h>
+#include <mbbiDirectRecord.h>
+#include <menuFtype.h>
+#include <stringinRecord.h>
+#include <stringoutRecord.h>
+
+// local includes
+#include "devIsegHal.h"
+#include "devIsegHalClasses.hpp"
+#include "devIsegHalDset.hpp"
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+//! @brief   Copy the engineering unit of the item if EGU is not set
+#define ISEG_EGU( prec, pinfo ) \
+  if( strlen( (prec)->egu ) == 0 ) strncpy( (prec)->egu, (pinfo)->unit, sizeof( (prec)->egu ) - 1 )
+
+//! @brief   ai records, R4 items
+struct isegAi : isegScalar {
+  typedef aiRecord record_t;
+  static constexpr const char* access() { return "R"; }
+  static constexpr const char* type() { return "R4"; }
+  static constexpr bool poll() { return false; }
+  static const struct link* ioLink( record_t *prec ) { return &prec->inp; }
+
+  static long init( record_t *prec, devIsegHal_info_t *pinfo ) {
+    ISEG_EGU( prec, pinfo );
+    prec->linr = 0;
+    return DO_NOT_CONVERT;
+  }
+  static long convert( record_t *prec, char *value ) {
+    return isegValue( (dbCommon *)prec, value, prec->val ) ? DO_NOT_CONVERT : ERROR;
+  }
+};
+
+//! @brief   ao records, R4 items
+//!
+//! Upon normal process of the record, the current contents of the VAL field
+//! is converted into a cstring. If PACT is set to true (process via callback)
+//! the cstring is instead parsed and its value written to VAL field.
+struct isegAo : isegScalar {
+  typedef aoRecord record_t;
+  static constexpr const char* access() { return "WR"; }
+  static constexpr const char* type() { return "R4"; }
+  static constexpr bool poll() { return true; }
+  static const struct link* ioLink( record_t *prec ) { return &prec->out; }
+
+  static long init( record_t *prec, devIsegHal_info_t *pinfo ) {
+    ISEG_EGU( prec, pinfo );
+    prec->linr = 0;
+    return OK;
+  }
+  static long convert( record_t *prec, char *value ) {
+    if( prec->pact ) return isegValue( (dbCommon *)prec, value, prec->val ) ? DO_NOT_CONVERT : ERROR;
+    return ( snprintf( value, VALUE_SIZE, "%lf", prec->val ) < 0 ) ? ERROR : OK;
+  }
+};
+
+//! @brief   bi records, BOOL items or single bits of an item
+struct isegBi : isegScalar {
+  typedef biRecord record_t;
+  static constexpr const char* access() { return "R"; }
+  static constexpr const char* type() { return "BOOL"; }
+  static constexpr bool poll() { return false; }
+  static const struct link* ioLink( record_t *prec ) { return &prec->inp; }
+
+  static long init( record_t *prec, devIsegHal_info_t *pinfo ) { return OK; }
+  static long convert( record_t *prec, char *value ) {
+    epicsUInt32 buffer = 0;
+    if( !isegValue( (dbCommon *)prec, value, buffer ) ) return ERROR;
+    prec->rval = ( buffer ? 1 : 0 );
+    return OK;
+  }
+};
+
+//! @brief   bo records, BOOL items
+struct isegBo : isegScalar {
+  typedef boRecord record_t;
+  static constexpr const char* access() { return "WR"; }
+  static constexpr const char* type() { return "BOOL"; }
+  static constexpr bool poll() { return true; }
+  static const struct link* ioLink( record_t *prec ) { return &prec->out; }
+
+  static long init( record_t *prec, devIsegHal_info_t *pinfo ) { return OK; }
+  static long convert( record_t *prec, char *value ) {
+    if( prec->pact ) {
+      epicsUInt32 buffer = 0;
+      if( !isegValue( (dbCommon *)prec, value, buffer ) ) return ERROR;
+      prec->val  = ( buffer ? 1 : 0 );
+      prec->rval = ( buffer ? 1 : 0 );
+      return OK;
+    }
+    value[0] = ( prec->rval ? '1' : '0' );
+    value[1] = 0;
+    return OK;
+  }
+};
+
+//! @brief   longin records, UI items
+struct isegLi : isegScalar {
+  typedef longinRecord record_t;
+  static constexpr const char* access() { return "R"; }
+  static constexpr const char* type() { return "UI"; }
+  static constexpr bool poll() { return false; }
+  static const struct link* ioLink( record_t *prec ) { return &prec->inp; }
+
+  static long init( record_t *prec, devIsegHal_info_t *pinfo ) {
+    ISEG_EGU( prec, pinfo );
+    return OK;
+  }
+  static long convert( record_t *prec, char *value ) {
+    epicsUInt32 buffer = 0;
+    if( !isegValue( (dbCommon *)prec, value, buffer ) ) return ERROR;
+    prec->val = (epicsInt32)buffer;
+    return OK;
+  }
+};
+
+//! @brief   longout records, UI items
+struct isegLo : isegScalar {
+  typedef longoutRecord record_t;
+  static constexpr const char* access() { return "WR"; }
+  static constexpr const char* type() { return "UI"; }
+  static constexpr bool poll() { return true; }
+  static const struct link* ioLink( record_t *prec ) { return &prec->out; }
+
+  static long init( record_t *prec, devIsegHal_info_t *pinfo ) {
+    ISEG_EGU( prec, pinfo );
+    return OK;
+  }
+  static long convert( record_t *prec, char *value ) {
+    if( prec->pact ) {
+      epicsUInt32 buffer = 0;
+      if( !isegValue( (dbCommon *)prec, value, buffer ) ) return ERROR;
+      prec->val = (epicsInt32)buffer;
+      return OK;
+    }
+    return ( snprintf( value, VALUE_SIZE, "%d", prec->val ) < 0 ) ? ERROR : OK;
+  }
+};
+
+//! @brief   mbbiDirect records, UI items
+struct isegMbbid : isegScalar {
+  typedef mbbiDirectRecord record_t;
+  static constexpr const char* access() { return "R"; }
+  static constexpr const char* type() { return "UI"; }
+  static constexpr bool poll() { return false; }
+  static const struct link* ioLink( record_t *prec ) { return &prec->inp; }
+
+  static long init( record_t *prec, devIsegHal_info_t *pinfo ) {
+    prec->mask <<= prec->shft;
+    return OK;
+  }
+  static long convert( record_t *prec, char *value ) {
+    epicsUInt32 buffer = 0;
+    if( !isegValue( (dbCommon *)prec, value, buffer ) ) return ERROR;
+    if( prec->mask ) {
+      prec->rval = buffer & prec->mask;
+      return OK;
+    }
+    // No MASK, (NOBT = 0): use VAL field
+    prec->val = (epicsUInt16)( buffer & 0xffff );
+    return DO_NOT_CONVERT;
+  }
+};
+
+//! @brief   stringin records, STR items
+struct isegSi : isegScalar {
+  typedef stringinRecord record_t;
+  static constexpr const char* access() { return "R"; }
+  static constexpr const char* type() { return "STR"; }
+  static constexpr bool poll() { return false; }
+  static const struct link* ioLink( record_t *prec ) { return &prec->inp; }
+
+  static long init( record_t *prec, devIsegHal_info_t *pinfo ) { return OK; }
+  static long convert( record_t *prec, char *value ) {
+    size_t valLen = strlen( value );
+    if( MAX_STRING_SIZE <= valLen ) {
+      fprintf( stderr, "\033[31;1m%s: Value string too long, truncating! Lentgh: %lu\033[0m\n",
+               prec->name, (unsigned long)valLen );
+    }
+    strncpy( prec->val, value, MAX_STRING_SIZE - 1 );
+    prec->val[ MAX_STRING_SIZE - 1 ] = 0; // to be sure, VAL is null terminated
+    return OK;
+  }
+};
+
+//! @brief   stringout records, STR items
+struct isegSo : isegScalar {
+  typedef stringoutRecord record_t;
+  static constexpr const char* access() { return "W"; }
+  static constexpr const char* type() { return "STR"; }
+  static constexpr bool poll() { return false; }
+  static const struct link* ioLink( record_t *prec ) { return &prec->out; }
+
+  static long init( record_t *prec, devIsegHal_info_t *pinfo ) {
+    prec->udf = (epicsUInt8)false;
+    return OK;
+  }
+  static long convert( record_t *prec, char *value ) {
+    strncpy( value, prec->val, MAX_STRING_SIZE );
+    return OK;
+  }
+};
+
+//------------------------------------------------------------------------------
+//! @brief       Copy the values of all channels to the buffer of an array record
+//! @param [in]  prec  Address of the aai or aao record
+//------------------------------------------------------------------------------
+template< class R >
+static long isegArrayIn( R *prec ) {
+  devIsegHal_info_t *pinfo = (devIsegHal_info_t *)prec->dpvt;
+  if( !pinfo || !pinfo->parray || !prec->bptr ) return OK; // not yet initialized
+  epicsGuard< epicsMutex > guard( pinfo->parray->lock );
+  std::vector< epicsFloat64 > const& values = pinfo->parray->values;
+  epicsUInt32 n = ( values.size() < prec->nelm ) ? values.size() : prec->nelm;
+  switch( prec->ftvl ) {
+    case menuFtypeDOUBLE: isegCopyArray( (epicsFloat64 *)prec->bptr, values, n ); break;
+    case menuFtypeFLOAT:  isegCopyArray( (epicsFloat32 *)prec->bptr, values, n ); break;
+    case menuFtypeLONG:   isegCopyArray( (epicsInt32 *)prec->bptr, values, n ); break;
+    case menuFtypeULONG:  isegCopyArray( (epicsUInt32 *)prec->bptr, values, n ); break;
+    case menuFtypeSHORT:  isegCopyArray( (epicsInt16 *)prec->bptr, values, n ); break;
+    case menuFtypeUSHORT: isegCopyArray( (epicsUInt16 *)prec->bptr, values, n ); break;
+    case menuFtypeCHAR:   isegCopyArray( (epicsInt8 *)prec->bptr, values, n ); break;
+    case menuFtypeUCHAR:  isegCopyArray( (epicsUInt8 *)prec->bptr, values, n ); break;
+    default:
+      fprintf( stderr, "\033[31;1m%s: FTVL not supported\033[0m\n", prec->name );
+      return ERROR;
+  }
+  prec->nord = n;
+  return OK;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Stage the buffer of an aao record to be written to all channels
+//! @param [in]  prec  Address of the aao record
+//!
+//! Only the first NORD channels are written. The staged values are taken
+//! into the write slot when the write is requested.
+//------------------------------------------------------------------------------
+static long isegArrayOut( aaoRecord *prec ) {
+  devIsegHal_info_t *pinfo = (devIsegHal_info_t *)prec->dpvt;
+  if( !pinfo || !pinfo->parray || !prec->bptr ) return ERROR;
+  std::vector< epicsFloat64 >& staged = pinfo->parray->staged;
+  size_t n = pinfo->parray->entries.size();
+  if( prec->nord < n ) n = prec->nord;
+  switch( prec->ftvl ) {
+    case menuFtypeDOUBLE: isegStageArray( staged, (epicsFloat64 *)prec->bptr, n ); break;
+    case menuFtypeFLOAT:  isegStageArray( staged, (epicsFloat32 *)prec->bptr, n ); break;
+    case menuFtypeLONG:   isegStageArray( staged, (epicsInt32 *)prec->bptr, n ); break;
+    case menuFtypeULONG:  isegStageArray( staged, (epicsUInt32 *)prec->bptr, n ); break;
+    case menuFtypeSHORT:  isegStageArray( staged, (epicsInt16 *)prec->bptr, n ); break;
+    case menuFtypeUSHORT: isegStageArray( staged, (epicsUInt16 *)prec->bptr, n ); break;
+    case menuFtypeCHAR:   isegStageArray( staged, (epicsInt8 *)prec->bptr, n ); break;
+    case menuFtypeUCHAR:  isegStageArray( staged, (epicsUInt8 *)prec->bptr, n ); break;
+    default:
+      fprintf( stderr, "\033[31;1m%s: FTVL not supported\033[0m\n", prec->name );
+      return ERROR;
+  }
+  return OK;
+}
+
+//! @brief   aai records, item of all channels of a module (R4 or UI items)
+//!
+//! INP is "@<line>.<module>.*.<item> <Interface>", element i is the item
+//! of channel i.
+struct isegAai {
+  typedef aaiRecord record_t;
+  static constexpr const char* access() { return "R"; }
+  static constexpr const char* type() { return ""; }
+  static constexpr bool poll() { return false; }
+  static const struct link* ioLink( record_t *prec ) { return &prec->inp; }
+  static epicsUInt32 nelm( record_t *prec ) { return prec->nelm; }
+
+  static long init( record_t *prec, devIsegHal_info_t *pinfo ) {
+    if( !pinfo->parray ) {
+      fprintf( stderr, "\033[31;1m%s: Invalid INP field, syntax is \"@<line>.<module>.*.<isegItem> <Interface>\"\033[0m\n",
+               prec->name );
+      return ERROR;
+    }
+    if( !prec->bptr ) prec->bptr = callocMustSucceed( prec->nelm, dbValueSize( prec->ftvl ), "devIsegHalAai" );
+    return isegArrayIn( prec );
+  }
+  static long convert( record_t *prec, char *value ) {
+    return isegArrayIn( prec );
+  }
+};
+
+//! @brief   aao records, writes an item of all channels of a module (R4 or UI items)
+//!
+//! OUT is "@<line>.<module>.*.<item> <Interface>", element i is written
+//! to channel i. All channels are written by one request, the put
+//! completes when the last channel has been written.
+struct isegAao {
+  typedef aaoRecord record_t;
+  static constexpr const char* access() { return "WR"; }
+  static constexpr const char* type() { return ""; }
+  static constexpr bool poll() { return true; }
+  static const struct link* ioLink( record_t *prec ) { return &prec->out; }
+  static epicsUInt32 nelm( record_t *prec ) { return prec->nelm; }
+
+  static long init( record_t *prec, devIsegHal_info_t *pinfo ) {
+    if( !pinfo->parray ) {
+      fprintf( stderr, "\033[31;1m%s: Invalid OUT field, syntax is \"@<line>.<module>.*.<isegItem> <Interface>\"\033[0m\n",
+               prec->name );
+      return ERROR;
+    }
+    if( !prec->bptr ) prec->bptr = callocMustSucceed( prec->nelm, dbValueSize( prec->ftvl ), "devIsegHalAao" );
+    return isegArrayIn( prec );
+  }
+  static long convert( record_t *prec, char *value ) {
+    if( prec->pact ) return isegArrayIn( prec );
+    value[0] = 0; // values are passed via the staged array
+    return isegArrayOut( prec );
+  }
+};
+
+//_____ G L O B A L S __________________________________________________________
+
+extern "C" {
+
+  devIsegHal_dset_t devIsegHalAi = {
+    7,
+    NULL,
+    (DEVSUPFUN)devIsegHalInit,
+    (DEVSUPFUN)isegDset< isegAi >::initRecord,
+    (DEVSUPFUN)devIsegHalGetIoIntInfo,
+    (DEVSUPFUN)devIsegHalRead,
+    NULL,
+    isegDset< isegAi >::convert
+  };
+  epicsExportAddress( dset, devIsegHalAi );
+
+  devIsegHal_dset_t devIsegHalAo = {
+    7,
+    NULL,
+    (DEVSUPFUN)devIsegHalInit,
+    (DEVSUPFUN)isegDset< isegAo >::initRecord,
+    NULL,
+    (DEVSUPFUN)devIsegHalWrite,
+    NULL,
+    isegDset< isegAo >::convert
+  };
+  epicsExportAddress( dset, devIsegHalAo );
+
+  devIsegHal_dset_t devIsegHalBi = {
+    7,
+    NULL,
+    (DEVSUPFUN)devIsegHalInit,
+    (DEVSUPFUN)isegDset< isegBi >::initRecord,
+    (DEVSUPFUN)devIsegHalGetIoIntInfo,
+    (DEVSUPFUN)devIsegHalRead,
+    NULL,
+    isegDset< isegBi >::convert
+  };
+  epicsExportAddress( dset, devIsegHalBi );
+
+  devIsegHal_dset_t devIsegHalBo = {
+    7,
+    NULL,
+    (DEVSUPFUN)devIsegHalInit,
+    (DEVSUPFUN)isegDset< isegBo >::initRecord,
+    NULL,
+    (DEVSUPFUN)devIsegHalWrite,
+    NULL,
+    isegDset< isegBo >::convert
+  };
+  epicsExportAddress( dset, devIsegHalBo );
+
+  devIsegHal_dset_t devIsegHalLi = {
+    7,
+    NULL,
+    (DEVSUPFUN)devIsegHalInit,
+    (DEVSUPFUN)isegDset< isegLi >::initRecord,
+    (DEVSUPFUN)devIsegHalGetIoIntInfo,
+    (DEVSUPFUN)devIsegHalRead,
+    NULL,
+    isegDset< isegLi >::convert
+  };
+  epicsExportAddress( dset, devIsegHalLi );
+
+  devIsegHal_dset_t devIsegHalLo = {
+    7,
+    NULL,
+    (DEVSUPFUN)devIsegHalInit,
+    (DEVSUPFUN)isegDset< isegLo >::initRecord,
+    NULL,
+    (DEVSUPFUN)devIsegHalWrite,
+    NULL,
+    isegDset< isegLo >::convert
+  };
+  epicsExportAddress( dset, devIsegHalLo );
+
+  devIsegHal_dset_t devIsegHalMbbid = {
+    7,
+    NULL,
+    (DEVSUPFUN)devIsegHalInit,
+    (DEVSUPFUN)isegDset< isegMbbid >::initRecord,
+    (DEVSUPFUN)devIsegHalGetIoIntInfo,
+    (DEVSUPFUN)devIsegHalRead,
+    NULL,
+    isegDset< isegMbbid >::convert
+  };
+  epicsExportAddress( dset, devIsegHalMbbid );
+
+  devIsegHal_dset_t devIsegHalSi = {
+    7,
+    NULL,
+    (DEVSUPFUN)devIsegHalInit,
+    (DEVSUPFUN)isegDset< isegSi >::initRecord,
+    (DEVSUPFUN)devIsegHalGetIoIntInfo,
+    (DEVSUPFUN)devIsegHalRead,
+    NULL,
+    isegDset< isegSi >::convert
+  };
+  epicsExportAddress( dset, devIsegHalSi );
+
+  devIsegHal_dset_t devIsegHalSo = {
+    7,
+    NULL,
+    (DEVSUPFUN)devIsegHalInit,
+    (DEVSUPFUN)isegDset< isegSo >::initRecord,
+    NULL,
+    (DEVSUPFUN)devIsegHalWrite,
+    NULL,
+    isegDset< isegSo >::convert
+  };
+  epicsExportAddress( dset, devIsegHalSo );
+
+  devIsegHal_dset_t devIsegHalAai = {
+    7,
+    NULL,
+    (DEVSUPFUN)devIsegHalInit,
+    (DEVSUPFUN)isegDset< isegAai >::initRecord,
+    (DEVSUPFUN)devIsegHalGetIoIntInfo,
+    (DEVSUPFUN)devIsegHalRead,
+    NULL,
+    isegDset< isegAai >::convert
+  };
+  epicsExportAddress( dset, devIsegHalAai );
+
+  devIsegHal_dset_t devIsegHalAao = {
+    7,
+    NULL,
+    (DEVSUPFUN)devIsegHalInit,
+    (DEVSUPFUN)isegDset< isegAao >::initRecord,
+    NULL,
+    (DEVSUPFUN)devIsegHalWrite,
+    NULL,
+    isegDset< isegAao >::convert
+  };
+  epicsExportAddress( dset, devIsegHalAao );
+
+} // extern "C"
+
@@ -0,0 +1,158 @@
+//******************************************************************************
+// Copyright (C) 2015 Florian Feldbauer <f.feldbauer@him.uni-mainz.de>
+//                    - Helmholtz-Institut Mainz
+//                    iseg Spezialelektronik GmbH
+//
+// This file is part of deviseg
+//
+// deviseg is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// deviseg is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// version 2.0.0; May 25, 2015
+//
+//******************************************************************************
+
+#ifndef devIsegHal_DSET_H
+#define devIsegHal_DSET_H
+
+//_____ I N C L U D E S ________________________________________________________
+
+// ANSI C/C++ includes
+#include <vector>
+
+// EPICS includes
+#include <dbCommon.h>
+#include <epicsTypes.h>
+
+// local includes
+#include "devIsegHal.h"
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+//------------------------------------------------------------------------------
+//! @brief       Get the value of a record as floating point number
+//! @param [in]  prec   Address of the record
+//! @param [in]  value  Value cstring passed to conv_val_str
+//! @param [out] val    Value
+//! @return      false if the value cstring is not a number
+//!
+//! Takes the value slot if the value cstring of the record is passed,
+//! which has been parsed by the worker already.
+//------------------------------------------------------------------------------
+inline bool isegValue( dbCommon *prec, const char *value, epicsFloat64& val ) {
+  devIsegHal_info_t *pinfo = (devIsegHal_info_t *)prec->dpvt;
+  if( pinfo && value == pinfo->value && ISEG_VALUE_DOUBLE == pinfo->vtype ) {
+    if( !pinfo->vvalid ) return false;
+    val = pinfo->num.f64;
+    return true;
+  }
+  return ( 0 == devIsegHalParseDouble( value, &val ) );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get the value of a record as unsigned integer
+//! @param [in]  prec   Address of the record
+//! @param [in]  value  Value cstring passed to conv_val_str
+//! @param [out] val    Value
+//! @return      false if the value cstring is not a number
+//------------------------------------------------------------------------------
+inline bool isegValue( dbCommon *prec, const char *value, epicsUInt32& val ) {
+  devIsegHal_info_t *pinfo = (devIsegHal_info_t *)prec->dpvt;
+  if( pinfo && value == pinfo->value && ISEG_VALUE_UINT == pinfo->vtype ) {
+    if( !pinfo->vvalid ) return false;
+    val = pinfo->num.u32;
+    return true;
+  }
+  return ( 0 == devIsegHalParseUInt32( value, &val ) );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Copy the values of an array record to its buffer
+//! @param [out] dest    Buffer of the record (BPTR) of field type E
+//! @param [in]  values  Values of the channels
+//! @param [in]  n       Number of elements to be copied
+//------------------------------------------------------------------------------
+template< class E >
+inline void isegCopyArray( E *dest, std::vector< epicsFloat64 > const& values, size_t n ) {
+  for( size_t i = 0; i < n; ++i ) dest[i] = (E)values[i];
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Copy the buffer of an array record to the values to be written
+//! @param [out] values  Values of the channels
+//! @param [in]  src     Buffer of the record (BPTR) of field type E
+//! @param [in]  n       Number of elements to be copied
+//------------------------------------------------------------------------------
+template< class E >
+inline void isegStageArray( std::vector< epicsFloat64 >& values, E const *src, size_t n ) {
+  values.resize( n );
+  for( size_t i = 0; i < n; ++i ) values[i] = (epicsFloat64)src[i];
+}
+
+//! @brief   Defaults of the traits of scalar records
+struct isegScalar {
+  template< class R >
+  static epicsUInt32 nelm( R * ) { return 0; }
+};
+
+//! @brief   Device support of one record type
+//!
+//! Generates the record specific routines of a dset from a traits class T,
+//! which provides
+//!  - record_t: the record structure
+//!  - access(), type(): access and data type required from the isegHAL item
+//!  - poll(): register the record to the polling thread
+//!  - ioLink( prec ): the INP or OUT link
+//!  - nelm( prec ): max. number of elements of array records (see isegScalar)
+//!  - init( prec, pinfo ): record specific initialization,
+//!                         returns the status of init_record
+//!  - convert( prec, value ): conversion between VAL and value cstring
+//! The conversion is called directly by the generated conv_val_str, so it
+//! can be inlined into a few stores to the record fields.
+template< class T >
+class isegDset {
+ public:
+  typedef typename T::record_t record_t;
+
+  //----------------------------------------------------------------------------
+  //! @brief       Initialization of the record
+  //! @param [in]  prec   Address of the record calling this function
+  //! @return      In case of error return -1, otherwise the status of T::init
+  //----------------------------------------------------------------------------
+  static long initRecord( dbCommon *prec ) {
+    record_t *precord = (record_t *)prec;
+    prec->pact = (epicsUInt8)true; // disable record
+
+    devIsegHal_rec_t conf = { T::ioLink( precord ), T::access(), T::type(), T::poll(), T::nelm( precord ) };
+    long status = devIsegHalInitRecord( prec, &conf );
+    if( status != 0 ) return ERROR;
+
+    status = T::init( precord, (devIsegHal_info_t *)prec->dpvt );
+    prec->pact = (epicsUInt8)false; // enable record
+    return status;
+  }
+
+  //----------------------------------------------------------------------------
+  //! @brief       Convert between VAL field and value cstring
+  //! @param [in]  prec   Address of the record calling this function
+  //! @param [in]  value  Address of cstring containing value
+  //! @return      -1 in case of error, otherwise the status of T::convert
+  //----------------------------------------------------------------------------
+  static long convert( dbCommon *prec, char *value ) {
+    return T::convert( (record_t *)prec, value );
+  }
+};
+
+#endif
+
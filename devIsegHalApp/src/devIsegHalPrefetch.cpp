@@ -0,0 +1,241 @@
+//******************************************************************************
+// Copyright (C) 2015 Florian Feldbauer <f.feldbauer@him.uni-mainz.de>
+//                    - Helmholtz-Institut Mainz
+//                    iseg Spezialelektronik GmbH
+//
+// This file is part of deviseg
+//
+// deviseg is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// deviseg is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// version 2.0.0; May 25, 2015
+//
+//******************************************************************************
+
+
+//! @file devIsegHalPrefetch.cpp
+//! @brief Concurrent read of the items of all records before record init
+
+//_____ I N C L U D E S ________________________________________________________
+
+// ANSI C/C++ includes
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+// EPICS includes
+#include <dbAccess.h>
+#include <dbStaticLib.h>
+#include <epicsEvent.h>
+#include <epicsGuard.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+
+// local includes
+#include "devIsegHalClasses.hpp"
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+//! @brief   Items read by one session
+typedef struct {
+  std::string interface;      //!< deviseg name of the interface
+  std::string controller;     //!< hardware interface of the interface
+  std::string session;
+  std::vector< std::string > objects;
+  epicsEventId done;
+} isegPrefetchJob_t;
+
+//_____ G L O B A L S __________________________________________________________
+
+//_____ L O C A L S ____________________________________________________________
+
+//_____ F U N C T I O N S ______________________________________________________
+
+//------------------------------------------------------------------------------
+//! @brief       Get reference to the prefetch
+//------------------------------------------------------------------------------
+isegHalPrefetch& isegHalPrefetch::instance() {
+  static isegHalPrefetch myInstance;
+  return myInstance;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Thread reading the items of one job
+//! @param [in]  arg  Address of the job
+//------------------------------------------------------------------------------
+void isegHalPrefetch::fetch( void* arg ) {
+  isegPrefetchJob_t* job = (isegPrefetchJob_t*)arg;
+  isegHalPrefetch& self = instance();
+  isegHalConnectionHandler& handler = isegHalConnectionHandler::instance();
+
+  if( handler.connect( job->session, job->controller ) ) {
+    const char* session = job->session.c_str();
+    std::vector< std::string >::iterator it = job->objects.begin();
+    for( ; it != job->objects.end(); ++it ) {
+      isegHalCache::instance().property( job->interface, *it, session );
+      IsegItem item = iseg_getItem( session, it->c_str() );
+      epicsGuard< epicsMutex > guard( self._lock );
+      self._items[ job->interface + ":" + *it ] = item;
+    }
+    handler.disconnect( job->session );
+  } else {
+    fprintf( stderr, "\033[31;1mCannot connect prefetch session %s\033[0m\n", job->session.c_str() );
+  }
+  epicsEventSignal( job->done );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Read the items of all records
+//!
+//! Must be called before record initialization. Records using interfaces
+//! that are not registered (AUTO) are not considered. Each interface is
+//! read by its own sessions, all interfaces in parallel. The items of one
+//! module are read by the same session, the modules of an interface are
+//! distributed evenly over its sessions. Returns when all sessions are
+//! finished.
+//------------------------------------------------------------------------------
+void isegHalPrefetch::run() {
+  if( _sessions < 1 ) return;
+  isegHalConnectionHandler& handler = isegHalConnectionHandler::instance();
+  size_t numInterfaces = handler.numInterfaces();
+  if( numInterfaces < 1 ) return;
+
+  // collect the items of all records, grouped by interface and module
+  std::vector< std::map< std::string, std::vector< std::string > > > interfaces( numInterfaces );
+  size_t count = 0;
+  DBENTRY entry;
+  dbInitEntry( pdbbase, &entry );
+  for( long status = dbFirstRecordType( &entry ); !status; status = dbNextRecordType( &entry ) ) {
+    bool bi = ( 0 == strcmp( dbGetRecordTypeName( &entry ), "bi" ) );
+    for( status = dbFirstRecord( &entry ); !status; status = dbNextRecord( &entry ) ) {
+      if( dbFindField( &entry, "DTYP" ) || 0 != strcmp( dbGetString( &entry ), "isegHAL" ) ) continue;
+      if( dbFindField( &entry, "INP" ) && dbFindField( &entry, "OUT" ) ) continue;
+      const char* link = dbGetString( &entry );
+      if( !link || '@' != link[0] ) continue;
+
+      std::istringstream ss( link + 1 );
+      std::string object, interface;
+      if( !( ss >> object >> interface ) ) continue;
+      int index = handler.indexOf( interface );
+      if( index < 0 ) continue;
+      size_t colon = object.rfind( ':' );
+      if( bi && std::string::npos != colon ) object.erase( colon ); // bit of the item
+      size_t dot = object.find( '.' );
+      std::string module = object.substr( 0, object.find( '.', std::string::npos == dot ? dot : dot + 1 ) );
+
+      // array records: number of channels and item of channels 0 .. NELM-1
+      // of the module
+      std::vector< std::string > items;
+      size_t star = object.find( ".*." );
+      if( std::string::npos != star ) {
+        items.push_back( module + ".ChannelNumber" );
+        long nelm = dbFindField( &entry, "NELM" ) ? 0 : strtol( dbGetString( &entry ), NULL, 10 );
+        for( long i = 0; i < nelm; ++i ) {
+          std::ostringstream channel;
+          channel << object.substr( 0, star + 1 ) << i << object.substr( star + 2 );
+          items.push_back( channel.str() );
+        }
+      } else {
+        items.push_back( object );
+      }
+
+      std::vector< std::string >& objects = interfaces[ index ][ module ];
+      for( size_t i = 0; i < items.size(); ++i ) {
+        if( std::find( objects.begin(), objects.end(), items[i] ) != objects.end() ) continue;
+        objects.push_back( items[i] );
+        count++;
+      }
+    }
+  }
+  dbFinishEntry( &entry );
+
+  // per interface: largest modules first to the session with the fewest items
+  std::vector< isegPrefetchJob_t > jobs;
+  size_t numModules = 0;
+  for( size_t index = 0; index < numInterfaces; ++index ) {
+    std::map< std::string, std::vector< std::string > >& modules = interfaces[ index ];
+    if( modules.empty() ) continue;
+    numModules += modules.size();
+
+    std::vector< std::pair< size_t, std::string > > order;
+    std::map< std::string, std::vector< std::string > >::iterator it = modules.begin();
+    for( ; it != modules.end(); ++it ) order.push_back( std::make_pair( it->second.size(), it->first ) );
+    std::sort( order.rbegin(), order.rend() );
+
+    size_t first = jobs.size();
+    unsigned sessions = _sessions < modules.size() ? _sessions : modules.size();
+    jobs.resize( first + sessions );
+    for( unsigned i = 0; i < sessions; ++i ) {
+      std::ostringstream session;
+      session << handler.getName( index ) << "_INIT" << i;
+      jobs[first + i].interface = handler.getName( index );
+      jobs[first + i].controller = handler.getHalInterface( index );
+      jobs[first + i].session = session.str();
+    }
+    for( size_t i = 0; i < order.size(); ++i ) {
+      isegPrefetchJob_t* job = &jobs[first];
+      for( unsigned j = 1; j < sessions; ++j )
+        if( jobs[first + j].objects.size() < job->objects.size() ) job = &jobs[first + j];
+      std::vector< std::string > const& objects = modules[ order[i].second ];
+      job->objects.insert( job->objects.end(), objects.begin(), objects.end() );
+    }
+  }
+  if( jobs.empty() ) return;
+
+  epicsTimeStamp start, end;
+  epicsTimeGetCurrent( &start );
+  for( size_t i = 0; i < jobs.size(); ++i ) {
+    jobs[i].done = epicsEventMustCreate( epicsEventEmpty );
+    epicsThreadId tid = epicsThreadCreate( "isegPrefetch", epicsThreadPriorityMedium,
+                                           epicsThreadGetStackSize( epicsThreadStackMedium ), fetch, &jobs[i] );
+    if( !tid ) {
+      // read the items in this thread, the job signals done in any case
+      fprintf( stderr, "\033[31;1mCannot create prefetch thread for session %s, reading inline\033[0m\n",
+               jobs[i].session.c_str() );
+      fetch( &jobs[i] );
+    }
+  }
+  for( size_t i = 0; i < jobs.size(); ++i ) {
+    epicsEventMustWait( jobs[i].done );
+    epicsEventDestroy( jobs[i].done );
+  }
+  epicsTimeGetCurrent( &end );
+  printf( "Read %lu items of %lu modules over %lu sessions in %.3f s\n", (unsigned long)count,
+          (unsigned long)numModules, (unsigned long)jobs.size(), epicsTimeDiffInSeconds( &end, &start ) );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get the value of an item read before record init
+//! @param [in]  interface  Name of the interface
+//! @param [in]  object     Fully qualified object name of the item
+//! @param [out] item       Value of the item
+//! @return      false if the item has not been read
+//------------------------------------------------------------------------------
+bool isegHalPrefetch::take( std::string const& interface, std::string const& object, IsegItem& item ) {
+  epicsGuard< epicsMutex > guard( _lock );
+  std::map< std::string, IsegItem >::iterator it = _items.find( interface + ":" + object );
+  if( it == _items.end() ) return false;
+  item = it->second;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Drop the values after record init
+//------------------------------------------------------------------------------
+void isegHalPrefetch::clear() {
+  epicsGuard< epicsMutex > guard( _lock );
+  _items.clear();
+}
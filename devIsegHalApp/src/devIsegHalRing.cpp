@@ -0,0 +1,133 @@
+//******************************************************************************
+// Copyright (C) 2015 Florian Feldbauer <f.feldbauer@him.uni-mainz.de>
+//                    - Helmholtz-Institut Mainz
+//                    iseg Spezialelektronik GmbH
+//
+// This file is part of deviseg
+//
+// deviseg is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// deviseg is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// version 2.0.0; May 25, 2015
+//
+//******************************************************************************
+
+//! @file devIsegHalRing.cpp
+//! @brief Lock-free request queue of the worker threads
+
+//_____ I N C L U D E S ________________________________________________________
+
+// ANSI C/C++ includes
+#include <cstddef>
+
+// EPICS includes
+#include <epicsAtomic.h>
+
+// local includes
+#include "devIsegHalClasses.hpp"
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+//_____ G L O B A L S __________________________________________________________
+
+//_____ L O C A L S ____________________________________________________________
+
+//_____ F U N C T I O N S ______________________________________________________
+
+//------------------------------------------------------------------------------
+//! @brief       C'tor of isegHalRing
+//! @param [in]  capacity  Min. number of messages the queue can hold
+//------------------------------------------------------------------------------
+isegHalRing::isegHalRing( unsigned capacity )
+  : _cells( NULL ),
+    _mask( 0 ),
+    _head( 0 ),
+    _tail( 0 )
+{
+  size_t size = 2;
+  while( size < capacity ) size <<= 1;
+  _mask = size - 1;
+  _cells = new cell_t[ size ];
+  for( size_t i = 0; i < size; ++i ) _cells[i].seq = i;
+  epicsAtomicWriteMemoryBarrier();
+}
+
+//------------------------------------------------------------------------------
+//! @brief       D'tor of isegHalRing
+//------------------------------------------------------------------------------
+isegHalRing::~isegHalRing() {
+  delete [] _cells;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Add a message to the queue
+//! @param [in]  msg  Message to be added
+//! @return      false if the queue is full
+//!
+//! May be called by any thread. A producer claims a cell by advancing
+//! the head index, the cell's sequence number tells if the cell is free
+//! for this round and publishes the message to the consumer.
+//------------------------------------------------------------------------------
+bool isegHalRing::push( devIsegHal_msg_t const& msg ) {
+  cell_t *cell;
+  size_t pos = epicsAtomicGetSizeT( &_head );
+  while( true ) {
+    cell = &_cells[ pos & _mask ];
+    size_t seq = epicsAtomicGetSizeT( &cell->seq );
+    ptrdiff_t dif = (ptrdiff_t)seq - (ptrdiff_t)pos;
+    if( 0 == dif ) {
+      size_t prev = epicsAtomicCmpAndSwapSizeT( &_head, pos, pos + 1 );
+      if( prev == pos ) break;
+      pos = prev;
+    } else if( dif < 0 ) {
+      return false; // cell of previous round not yet consumed: full
+    } else {
+      pos = epicsAtomicGetSizeT( &_head );
+    }
+  }
+  cell->msg = msg;
+  epicsAtomicWriteMemoryBarrier();
+  epicsAtomicSetSizeT( &cell->seq, pos + 1 );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Take the oldest message from the queue
+//! @param [out] msg  Message
+//! @return      false if the queue is empty
+//!
+//! Must only be called by the owning worker thread
+//------------------------------------------------------------------------------
+bool isegHalRing::pop( devIsegHal_msg_t& msg ) {
+  cell_t *cell = &_cells[ _tail & _mask ];
+  size_t seq = epicsAtomicGetSizeT( &cell->seq );
+  if( (ptrdiff_t)seq - (ptrdiff_t)( _tail + 1 ) < 0 ) return false;
+
+  epicsAtomicReadMemoryBarrier();
+  msg = cell->msg;
+  epicsAtomicWriteMemoryBarrier();
+  epicsAtomicSetSizeT( &cell->seq, _tail + _mask + 1 );
+  epicsAtomicSetSizeT( &_tail, _tail + 1 );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Get number of messages in the queue
+//! @return      Number of queued messages (snapshot)
+//------------------------------------------------------------------------------
+size_t isegHalRing::pending() const {
+  size_t tail = epicsAtomicGetSizeT( &_tail );
+  size_t head = epicsAtomicGetSizeT( &_head );
+  return ( head > tail ) ? head - tail : 0;
+}
@@ -0,0 +1,136 @@
+//******************************************************************************
+// Copyright (C) 2015 Florian Feldbauer <f.feldbauer@him.uni-mainz.de>
+//                    - Helmholtz-Institut Mainz
+//                    iseg Spezialelektronik GmbH
+//
+// This file is part of deviseg
+//
+// deviseg is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// deviseg is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// version 2.0.0; May 25, 2015
+//
+//******************************************************************************
+
+
+//! @file devIsegHalParseBench.cpp
+//! @brief Microbenchmark of parsing the value cstrings of R4 items
+//!
+//! Compares the cost of parsing a value with sscanf, as done by conv_val_str
+//! on each record process before, with the parser used once per changed
+//! value by the worker threads. Only the parse cost per value is measured,
+//! not the processing of records.
+
+//_____ I N C L U D E S ________________________________________________________
+
+// ANSI C/C++ includes
+#include <cstdio>
+#include <cstdlib>
+
+// EPICS includes
+#include <epicsExport.h>
+#include <epicsTime.h>
+#include <iocsh.h>
+
+// local includes
+#include "devIsegHal.h"
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+//_____ L O C A L S ____________________________________________________________
+
+//! Typical values of R4 items as sent by isegHAL
+static const char* isegBenchValues[] = {
+  "1234.567", "0.000", "-12.5", "3000", "1.5E-06", "2.99792458E+08", "0.0012345", "-0.5E-3"
+};
+#define ISEG_BENCH_NVALUES ( sizeof( isegBenchValues ) / sizeof( isegBenchValues[0] ) )
+
+//_____ F U N C T I O N S ______________________________________________________
+
+//------------------------------------------------------------------------------
+//! @brief       Print result of one benchmark run
+//------------------------------------------------------------------------------
+static void isegParseBenchReport( const char* name, unsigned count, double sum,
+                                  epicsTimeStamp const& t0, epicsTimeStamp const& t1 ) {
+  double total = epicsTimeDiffInSeconds( &t1, &t0 );
+  printf( "%-22s %10.3f ms %12.0f values/s %8.1f ns parse cost/value (sum %g)\n",
+          name, total * 1.e3, count / total, total / count * 1.e9, sum );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Run the benchmark
+//! @param [in]  count  Number of values parsed by each parser
+//------------------------------------------------------------------------------
+static void isegParseBench( unsigned count ) {
+  epicsTimeStamp t0, t1;
+  double sum;
+
+  printf( "%u values parsed\n", count );
+
+  // before: each record process parses the value cstring
+  sum = 0.;
+  epicsTimeGetCurrent( &t0 );
+  for( unsigned i = 0; i < count; ++i ) {
+    epicsFloat64 val = 0.;
+    sscanf( isegBenchValues[ i % ISEG_BENCH_NVALUES ], "%lf", &val );
+    sum += val;
+  }
+  epicsTimeGetCurrent( &t1 );
+  isegParseBenchReport( "sscanf", count, sum, t0, t1 );
+
+  // parser as used by the worker, once per changed value
+  sum = 0.;
+  epicsTimeGetCurrent( &t0 );
+  for( unsigned i = 0; i < count; ++i ) {
+    epicsFloat64 val = 0.;
+    devIsegHalParseDouble( isegBenchValues[ i % ISEG_BENCH_NVALUES ], &val );
+    sum += val;
+  }
+  epicsTimeGetCurrent( &t1 );
+  isegParseBenchReport( "devIsegHalParseDouble", count, sum, t0, t1 );
+}
+
+//------------------------------------------------------------------------------
+
+extern "C" {
+
+  // iocsh callable function to run the parse benchmark
+  static const iocshArg parseBenchArg0 = { "values", iocshArgInt };
+  static const iocshArg * const parseBenchArgs[] = { &parseBenchArg0 };
+  static const iocshFuncDef parseBenchFuncDef = { "devIsegHalParseBench", 1, parseBenchArgs };
+
+  //----------------------------------------------------------------------------
+  //! @brief       iocsh callable function to run the parse benchmark
+  //!
+  //! This function can be called from the iocsh via
+  //! "devIsegHalParseBench( VALUES )"
+  //----------------------------------------------------------------------------
+  static void parseBenchCallFunc( const iocshArgBuf *args ) {
+    int count = args[0].ival > 0 ? args[0].ival : 1000000;
+    isegParseBench( count );
+  }
+
+  //----------------------------------------------------------------------------
+  //! @brief       Register functions to EPICS
+  //----------------------------------------------------------------------------
+  void devIsegHalParseBenchRegister( void ) {
+    static bool firstTime = true;
+    if ( firstTime ) {
+      iocshRegister( &parseBenchFuncDef, parseBenchCallFunc );
+      firstTime = false;
+    }
+  }
+
+  epicsExportRegistrar( devIsegHalParseBenchRegister );
+}
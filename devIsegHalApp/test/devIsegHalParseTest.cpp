@@ -0,0 +1,118 @@
+//******************************************************************************
+// Copyright (C) 2015 Florian Feldbauer <f.feldbauer@him.uni-mainz.de>
+//                    - Helmholtz-Institut Mainz
+//                    iseg Spezialelektronik GmbH
+//
+// This file is part of deviseg
+//
+// deviseg is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// deviseg is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// version 2.0.0; May 25, 2015
+//
+//******************************************************************************
+
+//! @file devIsegHalParseTest.cpp
+//! @brief Unit test of the value parsers used by the worker threads
+//!
+//! devIsegHalParseDouble and devIsegHalParseUInt32 replace sscanf, their
+//! results have to match strtod and sscanf( "%u" ) exactly.
+
+//_____ I N C L U D E S ________________________________________________________
+
+// ANSI C/C++ includes
+#include <cstdio>
+#include <cstdlib>
+
+// EPICS includes
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+// local includes
+#include "devIsegHal.h"
+
+//_____ D E F I N I T I O N S __________________________________________________
+
+//_____ L O C A L S ____________________________________________________________
+
+//! Values of R4 items, as sent by isegHAL and some corner cases
+static const char* isegDoubleValues[] = {
+  "1234.567", "0.000", "-12.5", "3000", "1.5E-06", "2.99792458E+08", "0.0012345", "-0.5E-3",
+  "  42.0", "+7", ".5", "5.", "1e22", "1e23", "1e-22", "1e-23", "123456789012345",
+  "1234567890123456789", "0.1234567890123456789", "1.7976931348623157e308", "4.9e-324",
+  "12.5V", "1e", "-0"
+};
+#define ISEG_NDOUBLES ( sizeof( isegDoubleValues ) / sizeof( isegDoubleValues[0] ) )
+
+//! Values of UI1/UI4 items
+static const char* isegUIntValues[] = {
+  "0", "1", "42", "255", "4294967295", " 17", "+3", "-1", "8mA"
+};
+#define ISEG_NUINTS ( sizeof( isegUIntValues ) / sizeof( isegUIntValues[0] ) )
+
+//! Cstrings without a number
+static const char* isegInvalidValues[] = { "", "abc", "-", "." };
+#define ISEG_NINVALID ( sizeof( isegInvalidValues ) / sizeof( isegInvalidValues[0] ) )
+
+//_____ F U N C T I O N S ______________________________________________________
+
+//------------------------------------------------------------------------------
+//! @brief       Compare devIsegHalParseDouble with strtod
+//------------------------------------------------------------------------------
+static void testParseDouble() {
+  testDiag( "devIsegHalParseDouble vs. strtod" );
+  for( unsigned i = 0; i < ISEG_NDOUBLES; ++i ) {
+    epicsFloat64 val = 0.;
+    int status = devIsegHalParseDouble( isegDoubleValues[i], &val );
+    double expected = strtod( isegDoubleValues[i], NULL );
+    testOk( 0 == status && val == expected, "'%s': %.17g (strtod %.17g)", isegDoubleValues[i], val, expected );
+  }
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Compare devIsegHalParseUInt32 with sscanf
+//------------------------------------------------------------------------------
+static void testParseUInt32() {
+  testDiag( "devIsegHalParseUInt32 vs. sscanf" );
+  for( unsigned i = 0; i < ISEG_NUINTS; ++i ) {
+    epicsUInt32 val = 0;
+    unsigned expected = 0;
+    int status = devIsegHalParseUInt32( isegUIntValues[i], &val );
+    sscanf( isegUIntValues[i], "%u", &expected );
+    testOk( 0 == status && val == expected, "'%s': %u (sscanf %u)", isegUIntValues[i], val, expected );
+  }
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Check that cstrings without a number are rejected
+//------------------------------------------------------------------------------
+static void testInvalid() {
+  testDiag( "cstrings without a number" );
+  for( unsigned i = 0; i < ISEG_NINVALID; ++i ) {
+    epicsFloat64 dval = 0.;
+    epicsUInt32 uval = 0;
+    testOk( -1 == devIsegHalParseDouble( isegInvalidValues[i], &dval ), "double '%s' rejected", isegInvalidValues[i] );
+    testOk( -1 == devIsegHalParseUInt32( isegInvalidValues[i], &uval ), "uint32 '%s' rejected", isegInvalidValues[i] );
+  }
+}
+
+//------------------------------------------------------------------------------
+
+MAIN( devIsegHalParseTest ) {
+  testPlan( ISEG_NDOUBLES + ISEG_NUINTS + 2 * ISEG_NINVALID );
+  testParseDouble();
+  testParseUInt32();
+  testInvalid();
+  return testDone();
+}
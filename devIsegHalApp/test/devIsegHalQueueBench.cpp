@@ -0,0 +1,280 @@
+//******************************************************************************
+// Copyright (C) 2015 Florian Feldbauer <f.feldbauer@him.uni-mainz.de>
+//                    - Helmholtz-Institut Mainz
+//                    iseg Spezialelektronik GmbH
+//
+// This file is part of deviseg
+//
+// deviseg is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// deviseg is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+//
+// version 2.0.0; May 25, 2015
+//
+//******************************************************************************
+
+//! @file devIsegHalQueueBench.cpp
+//! @brief Microbenchmark of the request queue of the worker threads
+//!
+//! Compares the lock-free isegHalRing carrying the compact handle messages
+//! with an epicsMessageQueue carrying the former request message including
+//! the value cstring. Several producer threads (scan threads, poller,
+//! callback threads) feed one consumer (the worker thread). Both consumers
+//! block while their queue is empty, the ring consumer waits for an event
+//! the same way as the worker threads do.
+
+//_____ I N C L U D E S ________________________________________________________
+
+// ANSI C/C++ includes
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// EPICS includes
+#include <epicsAtomic.h>
+#include <epicsEvent.h>
+#include <epicsExport.h>
+#include <epicsMessageQueue.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <iocsh.h>
+
+// local includes
+#include "devIsegHal.h"
+#include "devIsegHalClasses.hpp"
+
+//_____ D E F I N I T I O N S __________________________________________________
+#define BENCH_Q_SIZE 1000
+
+//! Request message as queued via epicsMessageQueue before
+typedef struct {
+  devIsegHal_info_t* pdata;
+  epicsUInt32 reqType;
+  char value[VALUE_SIZE];
+} devIsegHal_legacy_msg_t;
+
+//! Shared state of one benchmark run
+typedef struct {
+  epicsMessageQueueId queue;
+  isegHalRing *ring;
+  epicsEventId wakeup;    //!< Wakes up the ring consumer
+  int sleeping;           //!< Ring consumer waits for wakeup
+  epicsEventId start;
+  unsigned messages;      //!< Messages per producer
+  size_t full;            //!< Number of failed attempts to queue
+  double sendTime;        //!< Sum of time spent in producers [s]
+} isegBench_t;
+
+//_____ L O C A L S ____________________________________________________________
+
+//_____ F U N C T I O N S ______________________________________________________
+
+//------------------------------------------------------------------------------
+//! @brief       Producer thread feeding the epicsMessageQueue
+//! @param [in]  arg  Address of the benchmark state
+//------------------------------------------------------------------------------
+static void isegBenchQueueProducer( void *arg ) {
+  isegBench_t *pbench = (isegBench_t *)arg;
+  devIsegHal_legacy_msg_t msg;
+  msg.pdata = NULL;
+  msg.reqType = GET_ITEM;
+  msg.value[0] = 0;
+
+  epicsEventMustWait( pbench->start );
+  epicsEventSignal( pbench->start ); // release next producer
+
+  size_t full = 0;
+  epicsTimeStamp t0, t1;
+  epicsTimeGetCurrent( &t0 );
+  for( unsigned i = 0; i < pbench->messages; ++i ) {
+    while( 0 != epicsMessageQueueTrySend( pbench->queue, &msg, sizeof( msg ) ) ) {
+      ++full;
+      epicsThreadSleep( 0. );
+    }
+  }
+  epicsTimeGetCurrent( &t1 );
+
+  epicsAtomicAddSizeT( &pbench->full, full );
+  // end marker carries the elapsed time, summed up by the consumer
+  double *pdt = new double( epicsTimeDiffInSeconds( &t1, &t0 ) );
+  epicsMessageQueueSend( pbench->queue, &pdt, sizeof( pdt ) );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Add a message to the isegHalRing and wake up the consumer
+//! @param [in]  pbench  Address of the benchmark state
+//! @param [in]  msg     Message
+//! @return      false if the ring is full
+//------------------------------------------------------------------------------
+static bool isegBenchRingPost( isegBench_t *pbench, devIsegHal_msg_t const& msg ) {
+  if( !pbench->ring->push( msg ) ) return false;
+  // full barrier: publish the message before looking at the consumer's state
+  if( epicsAtomicAddIntT( &pbench->sleeping, 0 ) ) epicsEventSignal( pbench->wakeup );
+  return true;
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Producer thread feeding the isegHalRing
+//! @param [in]  arg  Address of the benchmark state
+//------------------------------------------------------------------------------
+static void isegBenchRingProducer( void *arg ) {
+  isegBench_t *pbench = (isegBench_t *)arg;
+  devIsegHal_msg_t msg;
+  msg.pdata = NULL;
+  msg.reqType = GET_ITEM;
+  msg.seq = 0;
+
+  epicsEventMustWait( pbench->start );
+  epicsEventSignal( pbench->start ); // release next producer
+
+  size_t full = 0;
+  epicsTimeStamp t0, t1;
+  epicsTimeGetCurrent( &t0 );
+  for( unsigned i = 0; i < pbench->messages; ++i ) {
+    msg.seq = i;
+    while( !isegBenchRingPost( pbench, msg ) ) {
+      ++full;
+      epicsThreadSleep( 0. );
+    }
+  }
+  epicsTimeGetCurrent( &t1 );
+
+  epicsAtomicAddSizeT( &pbench->full, full );
+  // end marker carries the elapsed time in usec
+  msg.reqType = CLOSE_CONN;
+  msg.seq = (epicsUInt32)( epicsTimeDiffInSeconds( &t1, &t0 ) * 1.e6 );
+  while( !isegBenchRingPost( pbench, msg ) ) epicsThreadSleep( 0. );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Print result of one benchmark run
+//------------------------------------------------------------------------------
+static void isegBenchReport( const char* name, isegBench_t const& bench, unsigned producers,
+                             epicsTimeStamp const& t0, epicsTimeStamp const& t1 ) {
+  double total = epicsTimeDiffInSeconds( &t1, &t0 );
+  double msgs = (double)bench.messages * producers;
+  printf( "%-18s %10.3f ms %12.0f msg/s %10.1f ns/enqueue %10lu full\n",
+          name, total * 1.e3, msgs / total, bench.sendTime / msgs * 1.e9, (unsigned long)bench.full );
+}
+
+//------------------------------------------------------------------------------
+//! @brief       Run the benchmark
+//! @param [in]  producers  Number of producer threads
+//! @param [in]  messages   Number of messages sent by each producer
+//------------------------------------------------------------------------------
+static void isegQueueBench( unsigned producers, unsigned messages ) {
+  isegBench_t bench;
+  epicsTimeStamp t0, t1;
+  unsigned prio = epicsThreadPriorityMedium;
+  unsigned stack = epicsThreadGetStackSize( epicsThreadStackSmall );
+
+  printf( "%u producer(s) x %u messages, message size %u vs. %u bytes\n", producers, messages,
+          (unsigned)sizeof( devIsegHal_legacy_msg_t ), (unsigned)sizeof( devIsegHal_msg_t ) );
+
+  // epicsMessageQueue
+  memset( &bench, 0, sizeof( bench ) );
+  bench.queue = epicsMessageQueueCreate( BENCH_Q_SIZE, sizeof( devIsegHal_legacy_msg_t ) );
+  bench.start = epicsEventMustCreate( epicsEventEmpty );
+  bench.messages = messages;
+  for( unsigned i = 0; i < producers; ++i )
+    epicsThreadCreate( "isegBenchQ", prio, stack, isegBenchQueueProducer, &bench );
+
+  epicsTimeGetCurrent( &t0 );
+  epicsEventSignal( bench.start );
+  devIsegHal_legacy_msg_t qmsg;
+  for( unsigned finished = 0; finished < producers; ) {
+    int n = epicsMessageQueueReceive( bench.queue, &qmsg, sizeof( qmsg ) );
+    if( n == (int)sizeof( double* ) ) {
+      double *pdt = NULL;
+      memcpy( &pdt, &qmsg, sizeof( pdt ) );
+      bench.sendTime += *pdt;
+      delete pdt;
+      ++finished;
+    }
+  }
+  epicsTimeGetCurrent( &t1 );
+  isegBenchReport( "epicsMessageQueue", bench, producers, t0, t1 );
+  epicsMessageQueueDestroy( bench.queue );
+  epicsEventDestroy( bench.start );
+
+  // isegHalRing
+  memset( &bench, 0, sizeof( bench ) );
+  bench.ring = new isegHalRing( BENCH_Q_SIZE );
+  bench.wakeup = epicsEventMustCreate( epicsEventEmpty );
+  bench.start = epicsEventMustCreate( epicsEventEmpty );
+  bench.messages = messages;
+  for( unsigned i = 0; i < producers; ++i )
+    epicsThreadCreate( "isegBenchR", prio, stack, isegBenchRingProducer, &bench );
+
+  epicsTimeGetCurrent( &t0 );
+  epicsEventSignal( bench.start );
+  devIsegHal_msg_t rmsg;
+  for( unsigned finished = 0; finished < producers; ) {
+    if( !bench.ring->pop( rmsg ) ) {
+      // announce the wait, then look again to not miss a message
+      epicsAtomicCmpAndSwapIntT( &bench.sleeping, 0, 1 );
+      if( !bench.ring->pop( rmsg ) ) {
+        epicsEventMustWait( bench.wakeup );
+        epicsAtomicSetIntT( &bench.sleeping, 0 );
+        continue;
+      }
+      epicsAtomicSetIntT( &bench.sleeping, 0 );
+    }
+    if( CLOSE_CONN == rmsg.reqType ) {
+      bench.sendTime += rmsg.seq * 1.e-6;
+      ++finished;
+    }
+  }
+  epicsTimeGetCurrent( &t1 );
+  isegBenchReport( "isegHalRing", bench, producers, t0, t1 );
+  delete bench.ring;
+  epicsEventDestroy( bench.wakeup );
+  epicsEventDestroy( bench.start );
+}
+
+//------------------------------------------------------------------------------
+
+extern "C" {
+
+  // iocsh callable function to run the queue benchmark
+  static const iocshArg queueBenchArg0 = { "producers", iocshArgInt };
+  static const iocshArg queueBenchArg1 = { "messages", iocshArgInt };
+  static const iocshArg * const queueBenchArgs[] = { &queueBenchArg0, &queueBenchArg1 };
+  static const iocshFuncDef queueBenchFuncDef = { "devIsegHalQueueBench", 2, queueBenchArgs };
+
+  //----------------------------------------------------------------------------
+  //! @brief       iocsh callable function to run the queue benchmark
+  //!
+  //! This function can be called from the iocsh via
+  //! "devIsegHalQueueBench( PRODUCERS, MESSAGES )"
+  //----------------------------------------------------------------------------
+  static void queueBenchCallFunc( const iocshArgBuf *args ) {
+    int producers = args[0].ival > 0 ? args[0].ival : 4;
+    int messages  = args[1].ival > 0 ? args[1].ival : 100000;
+    isegQueueBench( producers, messages );
+  }
+
+  //----------------------------------------------------------------------------
+  //! @brief       Register functions to EPICS
+  //----------------------------------------------------------------------------
+  void devIsegHalQueueBenchRegister( void ) {
+    static bool firstTime = true;
+    if ( firstTime ) {
+      iocshRegister( &queueBenchFuncDef, queueBenchCallFunc );
+      firstTime = false;
+    }
+  }
+
+  epicsExportRegistrar( devIsegHalQueueBenchRegister );
+}
+